@@ -0,0 +1,41 @@
+#ifndef BOTS_H
+#define BOTS_H
+
+#include "common.h"
+#include "match_slab.h"
+
+// Bot players and the bookkeeping that goes with them, shared by --sim
+// (bots in the handlers' seats, see sim.h), --tournament (bots on a match
+// slab, see tournament.h) and the benchmarks. Runs are made reproducible by
+// drawing every choice from a caller-owned xorshift32 state and folding
+// every move and result into an FNV-1a digest.
+
+#define DIGEST_INIT 14695981039346656037ULL // FNV-1a 64 offset basis
+
+// Next xorshift32 value; the state must not be 0
+unsigned int xorshift32(unsigned int *state);
+
+// Folds the 4 bytes of value into the digest
+unsigned long long digest_add(unsigned long long h, int value);
+
+// Monotonic wall time in seconds, for rates (never virtual time)
+double monotonic_seconds(void);
+
+// The n-th free cell of the board (n below the number of free cells), as
+// row * BOARD_SIZE + col
+int bot_free_cell(const char board[][BOARD_SIZE], int n);
+
+// A bot's move: greedy_top > 0 plays a random one of the evaluator's
+// greedy_top best moves (see evaluator.h), 0 a uniformly random free cell.
+// Returns row * BOARD_SIZE + col.
+int bot_move(const char board[][BOARD_SIZE], int player_count, int turn_count,
+             int seat, int greedy_top, unsigned int *rng);
+
+// Plays the next game of slab match id to the end, each seat moving as the
+// bot set with match_slab_set_bot() and the turn passing to the next
+// connected seat like the scheduler hands it on. Every move and the result
+// go into *digest. Returns the winner's 1-based seat, or 0 for a draw.
+int bot_play_game(MatchSlab *slab, long long id, unsigned int *rng,
+                  unsigned long long *digest);
+
+#endif // BOTS_H
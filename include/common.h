@@ -5,6 +5,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <signal.h>
@@ -14,13 +16,24 @@
 #include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <sys/wait.h>
 #include <time.h>
 
 // --- Game Constants ---
 #define SOCKET_PATH "/tmp/mega_ttt.sock"
+#define UPGRADE_SOCKET_PATH "/tmp/mega_ttt_upgrade.sock"
+#define ADMIN_SOCKET_PATH "/tmp/mega_ttt_admin.sock" // TOP k / RANK name
+#define SCORE_FILE "score.txt"
+#define RATINGS_FILE "ratings.txt" // Rating journal (see leaderboard.h)
+#define ADMIN_TOP_MAX 100              // Longest TOP k answer
+#define HINT_MAX 10                    // Most moves one HINT returns
+#define PREMOVE_MAX 8                  // Moves a player can queue (PRE r c)
+#define LOG_FILE "game_log.txt"
+#define GATEWAY_PORT 7000 // Default port of ./gateway
 #define MAX_PLAYERS 5
 #define MIN_PLAYERS 3
 #define BOARD_SIZE 12
@@ -28,7 +41,13 @@
 #define BUFFER_SIZE 256
 #define NAME_LEN 32
 #define POLL_INTERVAL_US 200000
+#define GAME_RESET_PAUSE_SEC 5 // Pause between a game's end and the next one
 #define LOG_BUFFER_SIZE 1024
+#define PLAYER_SYMBOLS "XOABC" // Seat i plays PLAYER_SYMBOLS[i]
+#define TOKEN_LEN 17            // 16 hex digits + NUL
+#define SESSION_GRACE_SEC 60    // How long a dropped seat is held for RESUME
+#define HELLO_TIMEOUT_SEC 2     // Time a new connection has to say JOIN/RESUME
+#define HELLO_PENDING_MAX 32    // Connections at once still sending that line
 
 // --- Shared Memory & Semaphores Names ---
 #define SHM_NAME "/mega_ttt_shm"
@@ -36,6 +55,10 @@
 #define SEM_TURN_NAME_PREFIX "/mega_ttt_turn_"
 #define SEM_SCHEDULER_NAME "/mega_ttt_scheduler"
 
+// --- File-Backed State (--state-file) ---
+#define STATE_MAGIC 0x5454544D // "MTTT"
+#define STATE_VERSION 4
+
 // --- Data Structures ---
 
 typedef struct {
@@ -44,9 +67,23 @@ typedef struct {
   char symbol;   // X, O, A, B, C
   int socket_fd; // Used by server child process
   int is_active;
+  char token[TOKEN_LEN]; // Session token issued at join, "" if never seated
+  time_t disconnected_at; // When the seat was vacated, for the grace window
 } Player;
 
+// A seat's connection state, kept by its handler process but stored here so
+// that it outlives the handler (a RESUME keeps the premoves, a hot upgrade
+// both)
+typedef struct {
+  int premoves[PREMOVE_MAX][2]; // Queued with "PRE r c", played in order
+  int premove_count;
+  char input[BUFFER_SIZE]; // Client input not yet handled, split into lines
+  int input_len;
+} SeatInput;
+
 typedef struct {
+  unsigned int magic;         // STATE_MAGIC once initialized
+  unsigned int version;       // STATE_VERSION, bumped on layout changes
   pthread_mutex_t game_mutex; // Process-Shared Mutex
   volatile char board[BOARD_SIZE][BOARD_SIZE];
   volatile int player_count;
@@ -55,7 +92,11 @@ typedef struct {
   volatile int winner_id; // 0 if draw or none yet
   volatile int turn_count;
   volatile int win_counts[MAX_PLAYERS]; // Total wins for each player
+  volatile int result_saved; // 1 once the finished game is counted, after
+                             // its score line and rating are written
+  volatile int turn_stalled; // No seat present to hand the turn to
   Player players[MAX_PLAYERS];
+  SeatInput seat_input[MAX_PLAYERS]; // By seat, like players[]
 } GameState;
 
 // --- Helper Macros ---
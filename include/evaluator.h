@@ -0,0 +1,43 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "common.h"
+
+// Position evaluator behind HINT and the --sim greedy bots. A symbol's score
+// sums its runs of 2-4 stones in the four check_win directions, weighted by
+// length and by how many ends are open (a run closed at both ends scores
+// nothing); a run of WIN_COUNT or more scores EVAL_WIN_RUN.
+//
+// The kernel works on 16-byte rows, one lane per column, and walks each
+// direction row by row so all 12 lines advance together. Backends: AVX2
+// (two directions per step), SSE2, and a scalar reference.
+
+#define EVAL_SCALAR 0
+#define EVAL_SSE2 1
+#define EVAL_AVX2 2
+#define EVAL_BEST -1 // evaluator_init(): fastest the CPU supports
+
+#define EVAL_WIN_RUN 250
+
+typedef struct {
+  int row, col;
+  int score;
+} MoveHint;
+
+// Picks the backend. Returns the one in use (a backend the CPU lacks falls
+// back to the next best).
+int evaluator_init(int backend);
+const char *evaluator_name(void);
+
+int evaluate_symbol(const char board[][BOARD_SIZE], char symbol);
+// Scores of PLAYER_SYMBOLS[0..players-1]
+void evaluate_position(const char board[][BOARD_SIZE], int players,
+                       int *scores);
+
+// Ranks the empty cells for seat: what the move adds to the seat's own
+// score plus what it takes away from the strongest threat against it.
+// Fills the n best, best first, and returns how many there were.
+int suggest_moves(const char board[][BOARD_SIZE], int players, int seat,
+                  MoveHint *out, int n);
+
+#endif // EVALUATOR_H
@@ -3,9 +3,31 @@
 
 #include "common.h"
 
+// apply_move() results
+#define MOVE_INVALID 0
+#define MOVE_PLACED 1
+#define MOVE_WIN 2 // Game over, seat won
+#define MOVE_DRAW 3 // Game over, board full
+
 void init_game_state(GameState *gs);
 int is_valid_move(GameState *gs, int row, int col);
 int check_win(GameState *gs, int row, int col, char symbol);
 int is_board_full(GameState *gs);
 
+// Turn and game transitions shared by the server and --sim. Callers hold
+// game_mutex.
+// Places the seat's symbol, counts the turn and settles a finished game.
+int apply_move(GameState *gs, int seat, int row, int col);
+// The first present seat from `seat` on in round-robin order, or -1
+int next_seat(GameState *gs, int seat);
+// Clears the board, turn state and queued premoves for the next game;
+// players and win counts stay.
+void reset_game(GameState *gs);
+
+// The same rules on a bare board, for match state kept outside a GameState
+// (see match_slab.h). Empty cells hold ' '.
+int board_is_valid_move(const char board[][BOARD_SIZE], int row, int col);
+int board_check_win(const char board[][BOARD_SIZE], int row, int col,
+                    char symbol);
+
 #endif // GAME_LOGIC_H
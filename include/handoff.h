@@ -0,0 +1,22 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include "common.h"
+
+// Sent by a running server to its replacement (./server --takeover), followed
+// by the listening socket and one client socket per present seat via
+// SCM_RIGHTS. Absent seats keep their session and can RESUME on the new one.
+typedef struct {
+  int player_count;
+  int seat_count;            // Client sockets after the listener
+  int seat_of[MAX_PLAYERS];  // Seat index of each client socket
+  char state_path[256];      // Empty when the state lives in shm
+} HandoffInfo;
+
+int handoff_listen(const char *path);
+int handoff_connect(const char *path);
+int handoff_send(int conn, const HandoffInfo *info, int listen_fd,
+                 const int *client_fds);
+int handoff_recv(int conn, HandoffInfo *info, int *listen_fd, int *client_fds);
+
+#endif // HANDOFF_H
@@ -0,0 +1,46 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include "common.h"
+
+// Player ratings keyed by name. Ratings live in a treap ordered by rating
+// (ties by name) with subtree sizes, so rank-of and top-K are O(log n);
+// a name hash finds a player's node. Every change is appended to a journal
+// file that is replayed (and compacted) on the next start.
+//
+// Servers sharing a journal share the ratings: each takes a flock to
+// append, and replays what the others appended before rating a match or
+// answering a query.
+
+#define RATING_START 1500.0
+#define RATING_K 32.0 // Elo K-factor, spread over the pairwise games
+
+typedef struct {
+  char name[NAME_LEN];
+  double rating;
+  int games;
+} RatingEntry;
+
+// Replays the journal at path (NULL: keep ratings in memory only).
+// Returns the number of players loaded, or -1 if the journal can't be
+// opened for writing.
+int leaderboard_open(const char *path);
+void leaderboard_close(void);
+
+// Sets a player's rating, adding the player if new. Not journaled.
+void leaderboard_set(const char *name, double rating, int games);
+
+// Rates a finished match between n named players: seat winner (0-based)
+// beat everyone else, who drew among themselves; winner -1 is a draw.
+// Updates are pairwise Elo, applied together and journaled.
+void leaderboard_record_match(char names[][NAME_LEN], int n, int winner);
+
+// 1-based rank of name with its entry, or 0 if the player is unknown. Both
+// queries first catch up with the journal.
+int leaderboard_rank(const char *name, RatingEntry *out);
+
+// Fills out with the k best players; returns how many there were
+int leaderboard_top(int k, RatingEntry *out);
+int leaderboard_size(void);
+
+#endif // LEADERBOARD_H
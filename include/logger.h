@@ -0,0 +1,18 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "common.h"
+
+extern int log_pipe[2]; // [0] Read (Logger), [1] Write (Others)
+
+// Creates the log pipe. logger_thread() appends whatever log_msg() writes to
+// path, through io_uring when io_backend is IO_URING (see uring_io.h).
+void logger_init(const char *path, int io_backend);
+// The backend logger_thread() writes with: IO_BLOCKING once it has fallen
+// back from an io_uring it could not set up
+int logger_backend(void);
+void log_msg(const char *format, ...);
+void *logger_thread(void *arg);
+void logger_close(void);
+
+#endif // LOGGER_H
@@ -0,0 +1,104 @@
+#ifndef MATCH_SLAB_H
+#define MATCH_SLAB_H
+
+#include "common.h"
+
+// Slab of match states for hosting many matches in one process. Instead of
+// one GameState (and one mapping) per match, the slab keeps three parallel
+// arrays in a single mapping:
+//   hot    MatchHot, one cache line per match: everything a move touches
+//          besides the board, aligned so two cores never share a line.
+//   boards the 12x12 cells, packed back to back (144 bytes per match).
+//   cold   MatchCold: seat records and win counts, only read at seating
+//          and game over.
+// Freed matches go on a free list and are reused without touching the
+// mapping; a reset rewrites the header and the board only.
+//
+// A match id carries the slot in its low SLAB_SLOT_BITS and the slot's
+// 32-bit generation above them, so an id kept after its match was freed
+// (and the slot reused) is refused instead of reaching someone else's
+// match. The generation would only come round again after 2^32 reuses of
+// one slot.
+
+#define CACHE_LINE 64
+
+// match_slab_init() flags
+#define SLAB_HUGE_PAGES 1 // Back the slab with huge pages when available
+
+// How the slab ended up backed (MatchSlab.backing)
+#define SLAB_PAGES_NORMAL 0
+#define SLAB_PAGES_THP 1     // madvise(MADV_HUGEPAGE) accepted
+#define SLAB_PAGES_HUGETLB 2 // MAP_HUGETLB reservation
+
+#define SLAB_SLOT_BITS 24 // Low bits of an id; the generation sits above
+#define SLAB_MAX_CAPACITY (1 << SLAB_SLOT_BITS)
+
+typedef struct {
+  int turn_count;
+  int next_free; // Free list link while the slot is unused, else -1
+  unsigned int generation; // Bumped on every alloc, to spot stale ids
+  unsigned char player_count;
+  unsigned char current_player_index;
+  unsigned char game_over;
+  unsigned char winner_id; // 0 if draw or none yet
+  unsigned char in_use;
+  unsigned char active_mask; // Bit i set while seat i is connected
+} __attribute__((aligned(CACHE_LINE))) MatchHot;
+
+// A seat of a slab match. Only what a match itself needs: the network
+// side of a server seat (Player: session, name, connection) is not kept
+// here, so it never grows resident matches.
+typedef struct {
+  unsigned char id; // 1-based seat number
+  char symbol;
+  unsigned char greedy_top; // Bot in the seat (see bot_move()), 0: random
+} SlabSeat;
+
+typedef struct {
+  SlabSeat seats[MAX_PLAYERS];
+  int win_counts[MAX_PLAYERS];
+} MatchCold;
+
+typedef struct {
+  MatchHot *hot;
+  char (*boards)[BOARD_SIZE][BOARD_SIZE];
+  MatchCold *cold;
+  int capacity;
+  int in_use;
+  int free_head;
+  void *base; // The single mapping holding all three arrays
+  size_t bytes;
+  int backing; // SLAB_PAGES_*
+} MatchSlab;
+
+// Maps room for capacity matches (at most SLAB_MAX_CAPACITY). Returns -1 if
+// the mapping fails.
+int match_slab_init(MatchSlab *slab, int capacity, int flags);
+void match_slab_destroy(MatchSlab *slab);
+
+// Takes a match off the free list and seats player_count players (symbols
+// from PLAYER_SYMBOLS). Returns its id, or -1 when the slab is full.
+long long match_slab_alloc(MatchSlab *slab, int player_count);
+// Returns the match to the free list; stale ids are ignored
+void match_slab_free(MatchSlab *slab, long long id);
+
+// The slot behind a live id (an index into hot, boards and cold), or -1 if
+// the id is out of range or its match has been freed.
+int match_slab_slot(const MatchSlab *slab, long long id);
+
+// Starts the next game of a match: clears the board and turn state but
+// keeps the players and their win counts. Returns -1 for a stale id.
+int match_slab_reset(MatchSlab *slab, long long id);
+
+// The rules of game_logic.h on a slab match. match_slab_move() places the
+// seat's symbol, counts the turn and settles a finished game (winner and
+// win counts); it returns a MOVE_* result, MOVE_INVALID for a stale id.
+int match_slab_move(MatchSlab *slab, long long id, int seat, int row, int col);
+// The first connected seat from `seat` on in round-robin order, or -1
+int match_slab_next_seat(const MatchSlab *slab, long long id, int seat);
+
+// Puts a bot in the seat (greedy_top as for bot_move() in bots.h). Returns
+// -1 for a stale id or seat.
+int match_slab_set_bot(MatchSlab *slab, long long id, int seat, int greedy_top);
+
+#endif // MATCH_SLAB_H
@@ -0,0 +1,41 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include "common.h"
+
+// Where the server runs. The match's handler processes, and the GameState
+// they all lock and write, go on the game cores; the monitor loop, logger
+// and scheduler go on the I/O cores, so their wakeups stay out of the game
+// cores' caches. A connection is served by its seat's handler, so its
+// socket work lands on the game cores too. Without --cpus nothing is
+// pinned. Linux only; elsewhere placement_configure() fails.
+
+#define PLACEMENT_MAX_CPUS 256
+
+// Per-core busy share between two /proc/stat samples
+typedef struct {
+  int cpu;
+  double busy;      // Percent of the interval
+  const char *role; // "game", "io", "game+io" or "-"
+} CpuUsage;
+
+// game_list: "auto" or a CPU list like "0-3,6"; io_list: a CPU list, or
+// NULL for the allowed CPUs outside the game set (auto: the last CPU of the
+// game node). A NULL game_list pins nothing and only starts the usage
+// clock. Prints the plan. Returns 0, or -1 on a bad or unusable list.
+int placement_configure(const char *game_list, const char *io_list);
+int placement_enabled(void);
+
+// Pin the calling thread (and what it creates or forks from then on)
+void placement_pin_game(void);
+void placement_pin_io(void);
+
+// Prefers the game node for a mapping, moving pages already placed
+// elsewhere. Pages touched after placement_pin_game() land there anyway.
+void placement_bind_memory(void *addr, size_t len);
+
+// Usage of every online CPU since the previous call (or since the first
+// one); with since_start, since the first call. Returns the CPU count.
+int placement_usage(CpuUsage *out, int max, int since_start);
+
+#endif // PLACEMENT_H
@@ -0,0 +1,19 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "common.h"
+
+// --sim: plays `games` full games between in-process bots on virtual time
+// (see vclock.h). The bots are threads in the handlers' place, driven by
+// the server's scheduler thread and turn semaphores (see turns.h), and a
+// match thread does the monitor's part. The games are split over `matches`
+// independent matches, each with its own state, semaphores and virtual
+// clock, run in parallel threads. Everything is derived from seed, and a
+// clock wakes one thread at a time, so a run is reproducible for a given
+// number of matches; the printed digest covers every move and result. The
+// first `greedy` seats play the evaluator's best move (see evaluator.h)
+// instead of random ones. Returns 0.
+int sim_run(int players, int games, unsigned int seed, int greedy,
+            int matches);
+
+#endif // SIM_H
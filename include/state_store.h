@@ -0,0 +1,18 @@
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include "common.h"
+
+// Maps the shared GameState. With a NULL path it uses the POSIX shm segment
+// shm_name (SHM_NAME, or a per-instance variant); otherwise it maps the given file so the state survives a server
+// crash. *warm is set to 1 when an existing, valid state was reattached.
+// The shm segment is only reattached when reuse_shm is set (--takeover); in
+// that mode an invalid state is left untouched and NULL is returned.
+GameState *state_store_open(const char *shm_name, const char *state_path,
+                            int players_needed, int reuse_shm, int *warm);
+int state_store_validate(GameState *gs, int players_needed);
+void state_store_sync(GameState *gs);
+void state_store_detach(GameState *gs);
+void state_store_close(GameState *gs, const char *state_path);
+
+#endif // STATE_STORE_H
@@ -0,0 +1,43 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include "common.h"
+
+// --tournament: plays a roster of bots against each other on worker
+// threads, each on a match slab of its own (see match_slab.h), with
+// the server's move rules and round-robin turn order (bot_play_game() in
+// bots.h). Every table plays whole seat rotations, so each bot sits in
+// every seat (and plays every symbol) equally often. Games are seeded from their place in the schedule, so results do
+// not depend on the thread count; the printed digest covers them all.
+//
+// Roster file, one bot per line ('#' starts a comment):
+//   <name> random | greedy | greedy<N>
+// greedy plays the evaluator's best move (see evaluator.h), greedy<N> a
+// random one of its N best.
+
+#define TOURNEY_ROUND_ROBIN 0 // Every group of `players` bots meets
+#define TOURNEY_SWISS 1       // Rounds of tables by score, few rematches
+#define TOURNEY_ROTATE 2      // One table of exactly `players` bots
+
+#define ROSTER_MAX 64
+#define TOURNEY_MAX_GAMES 10000000
+#define TOURNEY_THREADS_MAX 256
+
+typedef struct {
+  const char *roster_path;
+  int format;      // TOURNEY_*
+  int players;     // Bots per table (MIN_PLAYERS..MAX_PLAYERS)
+  int rotations;   // Seat rotations per table, `players` games each
+  int rounds;      // Swiss rounds, 0 for enough to rank the roster
+  int threads;     // 0 for one per online CPU
+  unsigned int seed;
+} TournamentConfig;
+
+// Parses "roundrobin", "swiss" or "rotate"; -1 if unknown
+int tournament_format(const char *name);
+
+// Runs the tournament and prints the standings. Returns 0, or -1 if the
+// roster or the schedule is unusable.
+int tournament_run(const TournamentConfig *cfg);
+
+#endif // TOURNAMENT_H
@@ -0,0 +1,77 @@
+#ifndef TURNS_H
+#define TURNS_H
+
+#include "common.h"
+
+// Turn flow of a match, shared by the server (handler processes, scheduler
+// thread, monitor loop) and --sim's in-process bot seats (see sim.h).
+//
+// A seat moves only while holding its turn semaphore. After a move it posts
+// sem_scheduler; the scheduler thread then offers the turn to the next
+// present seat. The monitor counts a finished game and starts the next one,
+// whose first turn is offered right away. Every wait and post goes through
+// vclock, so under --sim the same code runs on virtual time.
+
+// One match's turn state. The server has one (see server.c); --sim has one
+// per simulated match.
+typedef struct {
+  GameState *gs;
+  sem_t *turn_sems[MAX_PLAYERS];
+  sem_t *sem_scheduler; // Posted after every finished turn
+  sem_t *sem_game_over; // Posted by the move that ends a game, if set
+  int quiet;            // No per-turn console lines (--sim)
+} Turns;
+
+// A finished game as the monitor records it
+typedef struct {
+  int winner; // 1-based seat, 0 for a draw
+  int turns;
+  int seats;
+  int total_wins;    // The winner's, this game included
+  int already_saved; // Counted and saved before a restart
+  char winner_symbol; // '?' for a draw
+  char names[MAX_PLAYERS][NAME_LEN];
+} GameResult;
+
+// Hands the turn to the first present seat from `seat` on. Caller holds
+// game_mutex. Returns the seat, or -1 when nobody is present and the turn
+// waits for a player to come back.
+int offer_turn(Turns *t, int seat);
+
+// Round-robin scheduler thread (arg: the Turns): runs until cancelled
+void *scheduler_thread(void *arg);
+
+// Drops stale posts and offers the turn to whoever holds it
+void restart_turns(Turns *t, int players_needed);
+
+// Waits up to us (us < 0: for as long as it takes) for the seat's turn.
+// Returns 0 once it is ours.
+int wait_for_turn(Turns *t, int seat, long us);
+
+// Plays a move for the seat holding the turn and passes the turn on.
+// Returns apply_move()'s result; MOVE_INVALID changes nothing.
+int play_move(Turns *t, int seat, int row, int col);
+
+// Marks the seat absent; once the match has started its player may come
+// back within SESSION_GRACE_SEC (the server frees a lobby seat). If the
+// seat held the turn (or had just been offered it) the turn passes on.
+void vacate_seat(Turns *t, int seat, int holding_turn);
+
+// A player is back in the seat: a match nobody was present for resumes
+// with them. Returns 1 if the turn had stalled.
+int resume_turn(Turns *t, int seat);
+
+// Copies the finished game's result, its win included in total_wins.
+// Caller holds game_mutex.
+void read_result(Turns *t, GameResult *result);
+
+// Counts the finished game in win_counts and sets result_saved in the same
+// step, once its score line and rating are written: a restart in between
+// writes them again rather than counting the win twice. Does nothing the
+// second time. Caller holds game_mutex.
+void count_result(Turns *t);
+
+// Starts the next game: clears the board and offers the first turn
+void start_next_game(Turns *t, int players_needed);
+
+#endif // TURNS_H
@@ -0,0 +1,58 @@
+#ifndef URING_IO_H
+#define URING_IO_H
+
+#include "common.h"
+
+// Minimal io_uring ring (raw syscalls, no liburing) for batching socket and
+// log I/O. On systems without io_uring, uring_init() fails and callers stay
+// on their blocking path.
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#endif
+
+// --io option
+#define IO_BLOCKING 0
+#define IO_URING 1
+
+typedef struct {
+  int fd;
+  unsigned entries;
+  unsigned sq_tail; // Local tail, published on submit
+  unsigned to_submit;
+  unsigned *sq_khead, *sq_ktail, *sq_mask, *sq_array;
+  unsigned *cq_khead, *cq_ktail, *cq_mask;
+  void *sqes; // struct io_uring_sqe[entries]
+  void *cqes; // struct io_uring_cqe[]
+  void *sq_ring, *cq_ring;
+  size_t sq_ring_len, cq_ring_len, sqes_len;
+} UringIO;
+
+int uring_init(UringIO *ring, unsigned entries);
+void uring_exit(UringIO *ring);
+int uring_register_buffers(UringIO *ring, const struct iovec *iovs,
+                           unsigned count);
+
+// Queue operations; they run on the next uring_submit(). With link set,
+// the next queued operation starts only once this one has completed.
+// Return -1 when the submission queue is full.
+int uring_prep_write_fixed(UringIO *ring, int fd, const void *buf,
+                           unsigned len, off_t offset, int buf_index,
+                           int link, unsigned long long user_data);
+int uring_prep_send(UringIO *ring, int fd, const void *buf, unsigned len,
+                    int link, unsigned long long user_data);
+
+// Submits queued operations and waits for at least wait_nr completions.
+int uring_submit(UringIO *ring, unsigned wait_nr);
+// Waits for wait_nr completions without submitting what is queued
+int uring_wait(UringIO *ring, unsigned wait_nr);
+
+// Pops one completion. Returns 1 with user_data/res filled, 0 if none.
+int uring_reap(UringIO *ring, unsigned long long *user_data, int *res);
+
+// Sends two messages back to back: as linked SENDs in one submission when
+// the ring is up (fd != -1), otherwise as two blocking sends.
+void send_pair(UringIO *ring, int sock, const char *first, size_t first_len,
+               const char *second, size_t second_len);
+
+#endif // URING_IO_H
@@ -0,0 +1,55 @@
+#ifndef VCLOCK_H
+#define VCLOCK_H
+
+#include "common.h"
+
+// Clock used for every wait and timestamp in the game flow. Normally it is
+// the wall clock; under --sim each simulated match runs on a virtual clock
+// of its own, so runs are fast and reproducible and independent matches
+// can run side by side.
+//
+// A virtual clock is a discrete-event clock shared by the threads of one
+// match (its participants). It only moves when every participant is
+// blocked in one of the waits below: it then jumps to the earliest
+// deadline and wakes that one waiter (the lowest thread id on a tie).
+// Semaphores the participants wait on must be posted with
+// vclock_sem_post() so the clock sees the wake-up.
+
+typedef struct VClockWaiter VClockWaiter;
+
+typedef struct {
+  pthread_mutex_t lock;
+  long long now_us; // Virtual time, from the epoch
+  int participants, blocked;
+  int next_id; // Thread id of the next participant
+  VClockWaiter *waiters;
+} VClock;
+
+// Starts clock at the epoch, with the calling thread as participant 0.
+// Until it calls vclock_thread_exit() its waits run on that clock.
+void vclock_init(VClock *clock);
+// Once every participant has left
+void vclock_destroy(VClock *clock);
+// The calling thread's virtual clock, NULL on the wall clock
+VClock *vclock_current(void);
+
+// pthread_create() for a thread that waits on the creator's clock: it takes
+// part in virtual time until it returns or is cancelled. Ids follow
+// creation order.
+int vclock_thread_create(pthread_t *tid, void *(*fn)(void *), void *arg);
+// The calling thread stops taking part and goes back to the wall clock,
+// e.g. before a pthread_join()
+void vclock_thread_exit(void);
+
+void vclock_sleep_us(long us);
+void vclock_sleep(int sec);
+time_t vclock_now(void);  // Seconds, like time(NULL)
+long long vclock_now_us(void);
+
+// Semaphore operations on the clock. vclock_sem_timedwait() gives up after
+// us and then returns -1 with errno ETIMEDOUT.
+int vclock_sem_wait(sem_t *sem);
+int vclock_sem_timedwait(sem_t *sem, long us);
+int vclock_sem_post(sem_t *sem);
+
+#endif // VCLOCK_H
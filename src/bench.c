@@ -0,0 +1,332 @@
+#include "../include/common.h"
+#include "../include/bots.h"
+#include "../include/evaluator.h"
+#include "../include/game_logic.h"
+#include "../include/leaderboard.h"
+#include "../include/logger.h"
+#include "../include/match_slab.h"
+#include "../include/uring_io.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Micro-benchmarks for the server's I/O paths and match storage. The I/O
+// cases run once per backend so the two columns can be compared directly.
+//   ./bench [writers] [lines_per_writer] [prompts] [matches] [players]
+
+#define BENCH_LOG_FILE "/tmp/mega_ttt_bench_log.txt"
+
+// Handlers logging a game: every writer is its own process, like the
+// forked per-seat handlers. Returns -1 if the logger could not use
+// io_backend.
+double bench_logger(int io_backend, int writers, int lines) {
+  pthread_t tid;
+
+  unlink(BENCH_LOG_FILE);
+  logger_init(BENCH_LOG_FILE, io_backend);
+  pthread_create(&tid, NULL, logger_thread, NULL);
+
+  double start = monotonic_seconds();
+  for (int w = 0; w < writers; w++) {
+    pid_t pid = fork();
+    if (pid == -1)
+      ERR_EXIT("fork");
+    if (pid == 0) {
+      close(log_pipe[0]);
+      for (int i = 0; i < lines; i++)
+        log_msg("[Game] Player %d placed %c at (%d, %d)\n", w + 1,
+                PLAYER_SYMBOLS[w % MAX_PLAYERS], i % BOARD_SIZE,
+                (i / BOARD_SIZE) % BOARD_SIZE);
+      _exit(0);
+    }
+  }
+
+  // The logger sees EOF once every writer is gone
+  close(log_pipe[1]);
+  while (wait(NULL) > 0)
+    ;
+  pthread_join(tid, NULL);
+  double elapsed = monotonic_seconds() - start;
+  close(log_pipe[0]);
+  unlink(BENCH_LOG_FILE);
+  return logger_backend() == io_backend ? elapsed : -1;
+}
+
+void *drain_thread(void *arg) {
+  int sock = *(int *)arg;
+  char buf[BUFFER_SIZE];
+  while (recv(sock, buf, sizeof(buf), 0) > 0)
+    ;
+  return NULL;
+}
+
+// A handler prompting its player: board followed by YOUR_TURN
+double bench_prompts(int io_backend, int prompts) {
+  char board[2048];
+  const char *turn_cmd = "YOUR_TURN\n";
+  int sv[2];
+  pthread_t tid;
+  UringIO ring = {.fd = -1};
+
+  if (io_backend == IO_URING && uring_init(&ring, 4) == -1)
+    return -1;
+
+  // Same layout as the handler's board dump
+  int len = sprintf(board, "BOARD X\n   ");
+  for (int c = 0; c < BOARD_SIZE; c++)
+    len += sprintf(board + len, "%2d ", c);
+  len += sprintf(board + len, "\n");
+  for (int r = 0; r < BOARD_SIZE; r++) {
+    len += sprintf(board + len, "%2d ", r);
+    for (int c = 0; c < BOARD_SIZE; c++)
+      len += sprintf(board + len, "[ ]");
+    len += sprintf(board + len, "\n");
+  }
+  len += sprintf(board + len, "END\n");
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+    ERR_EXIT("socketpair");
+  pthread_create(&tid, NULL, drain_thread, &sv[1]);
+
+  double start = monotonic_seconds();
+  for (int i = 0; i < prompts; i++)
+    send_pair(&ring, sv[0], board, len, turn_cmd, strlen(turn_cmd));
+  shutdown(sv[0], SHUT_WR);
+  pthread_join(tid, NULL);
+  double elapsed = monotonic_seconds() - start;
+
+  close(sv[0]);
+  close(sv[1]);
+  if (ring.fd != -1)
+    uring_exit(&ring);
+  return elapsed;
+}
+
+long resident_bytes() {
+  long size, resident = 0;
+  FILE *fp = fopen("/proc/self/statm", "r");
+  if (fp) {
+    if (fscanf(fp, "%ld %ld", &size, &resident) != 2)
+      resident = 0;
+    fclose(fp);
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Many idle matches resident at once: one slab versus one GameState
+// mapping per match (what the server uses for its single match)
+void bench_slab(int matches) {
+  MatchSlab slab;
+  const char *backing[] = {"normal pages", "transparent huge pages",
+                           "hugetlb pages"};
+  long page = sysconf(_SC_PAGESIZE);
+
+  long long *ids = malloc(sizeof(long long) * matches);
+  if (!ids)
+    ERR_EXIT("malloc");
+  long before = resident_bytes();
+  if (match_slab_init(&slab, matches, SLAB_HUGE_PAGES) == -1) {
+    perror("match_slab_init");
+    free(ids);
+    return;
+  }
+  for (int i = 0; i < matches; i++)
+    ids[i] = match_slab_alloc(&slab, MIN_PLAYERS);
+  long resident = resident_bytes() - before;
+
+  size_t layout = sizeof(MatchHot) + sizeof(slab.boards[0]) +
+                  sizeof(MatchCold);
+  size_t segment = (sizeof(GameState) + page - 1) / page * page;
+  printf("\n%d matches in one slab (%s)\n", matches,
+         backing[slab.backing]);
+  printf("%-22s %10zu bytes (hot %zu, board %zu, cold %zu)\n",
+         "slab layout/match", layout, sizeof(MatchHot),
+         sizeof(slab.boards[0]), sizeof(MatchCold));
+  printf("%-22s %10ld bytes\n", "slab resident/match", resident / matches);
+  printf("%-22s %10zu bytes (GameState %zu + page rounding)\n",
+         "segment/match", segment, sizeof(GameState));
+
+  // Next game on every match: the slab rewrites header + board only
+  int rounds = 10;
+  double start = monotonic_seconds();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < matches; i++)
+      match_slab_reset(&slab, ids[i]);
+  double slab_reset =
+      (monotonic_seconds() - start) / ((double)rounds * matches);
+
+  GameState *states = calloc(matches, sizeof(GameState));
+  if (!states)
+    ERR_EXIT("calloc");
+  start = monotonic_seconds();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < matches; i++)
+      init_game_state(&states[i]);
+  double state_reset =
+      (monotonic_seconds() - start) / ((double)rounds * matches);
+  free(states);
+
+  // A match ending and a new one starting: free list versus a new mapping
+  start = monotonic_seconds();
+  for (int i = 0; i < matches; i++) {
+    match_slab_free(&slab, ids[i]);
+    ids[i] = match_slab_alloc(&slab, MIN_PLAYERS);
+  }
+  double slab_recycle = (monotonic_seconds() - start) / matches;
+
+  int remaps = matches < 20000 ? matches : 20000;
+  start = monotonic_seconds();
+  for (int i = 0; i < remaps; i++) {
+    GameState *gs = mmap(NULL, segment, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (gs == MAP_FAILED)
+      ERR_EXIT("mmap");
+    init_game_state(gs);
+    memset(gs->players, 0, sizeof(gs->players));
+    munmap(gs, segment);
+  }
+  double segment_recycle = (monotonic_seconds() - start) / remaps;
+
+  printf("%-22s %10.1f ns  (GameState %.1f ns)\n", "reset/match",
+         slab_reset * 1e9, state_reset * 1e9);
+  printf("%-22s %10.1f ns  (mmap+init+munmap %.1f ns)\n", "recycle/match",
+         slab_recycle * 1e9, segment_recycle * 1e9);
+  match_slab_destroy(&slab);
+  free(ids);
+}
+
+// Rank queries against a large rated population
+void bench_leaderboard(int players) {
+  char names[MAX_PLAYERS][NAME_LEN];
+  RatingEntry e, top[10];
+  unsigned int seed = 1;
+
+  double start = monotonic_seconds();
+  for (int i = 0; i < players; i++) {
+    char name[NAME_LEN];
+    snprintf(name, sizeof(name), "player%d", i);
+    leaderboard_set(name, 1000 + rand_r(&seed) % 1000, 1);
+  }
+  double load = (monotonic_seconds() - start) / players;
+
+  int queries = 100000;
+  start = monotonic_seconds();
+  for (int i = 0; i < queries; i++) {
+    char name[NAME_LEN];
+    snprintf(name, sizeof(name), "player%d", rand_r(&seed) % players);
+    leaderboard_rank(name, &e);
+  }
+  double rank = (monotonic_seconds() - start) / queries;
+
+  start = monotonic_seconds();
+  for (int i = 0; i < queries; i++)
+    leaderboard_top(10, top);
+  double top10 = (monotonic_seconds() - start) / queries;
+
+  // A 5-player match result: five re-ranks
+  start = monotonic_seconds();
+  for (int i = 0; i < queries; i++) {
+    for (int j = 0; j < MAX_PLAYERS; j++)
+      snprintf(names[j], NAME_LEN, "player%d", rand_r(&seed) % players);
+    leaderboard_record_match(names, MAX_PLAYERS, rand_r(&seed) % MAX_PLAYERS);
+  }
+  double match = (monotonic_seconds() - start) / queries;
+
+  printf("\n%d rated players\n", leaderboard_size());
+  printf("%-22s %10.1f ns\n", "insert/player", load * 1e9);
+  printf("%-22s %10.1f ns\n", "RANK name", rank * 1e9);
+  printf("%-22s %10.1f ns\n", "TOP 10", top10 * 1e9);
+  printf("%-22s %10.1f ns\n", "rate 5-player match", match * 1e9);
+  leaderboard_close();
+}
+
+// Position evaluation on random mid-game boards. The backends must agree
+// on every board before their speed means anything.
+void bench_evaluator() {
+  enum { BOARDS = 1000 };
+  static char boards[BOARDS][BOARD_SIZE][BOARD_SIZE];
+  int expected[BOARDS][MAX_PLAYERS];
+  unsigned int seed = 7;
+  const int backends[] = {EVAL_SCALAR, EVAL_SSE2, EVAL_AVX2};
+
+  for (int b = 0; b < BOARDS; b++) {
+    memset(boards[b], ' ', sizeof(boards[b]));
+    int stones = 20 + rand_r(&seed) % 80;
+    for (int i = 0; i < stones; i++)
+      boards[b][rand_r(&seed) % BOARD_SIZE][rand_r(&seed) % BOARD_SIZE] =
+          PLAYER_SYMBOLS[i % MAX_PLAYERS];
+  }
+
+  printf("\n%-22s %16s %18s\n", "evaluator", "5-player eval",
+         "HINT (3 players)");
+  for (int k = 0; k < 3; k++) {
+    if (evaluator_init(backends[k]) != backends[k])
+      continue; // Not on this CPU
+
+    int scores[MAX_PLAYERS];
+    for (int b = 0; b < BOARDS; b++) {
+      evaluate_position((const char(*)[BOARD_SIZE])boards[b], MAX_PLAYERS,
+                        scores);
+      if (k == 0) {
+        memcpy(expected[b], scores, sizeof(scores));
+      } else if (memcmp(expected[b], scores, sizeof(scores)) != 0) {
+        printf("%-22s MISMATCH on board %d\n", evaluator_name(), b);
+        break;
+      }
+    }
+
+    int rounds = 20;
+    double start = monotonic_seconds();
+    for (int i = 0; i < rounds; i++)
+      for (int b = 0; b < BOARDS; b++)
+        evaluate_position((const char(*)[BOARD_SIZE])boards[b], MAX_PLAYERS,
+                          scores);
+    double eval = (monotonic_seconds() - start) / (rounds * BOARDS);
+
+    MoveHint hints[3];
+    start = monotonic_seconds();
+    for (int b = 0; b < BOARDS / 10; b++)
+      suggest_moves((const char(*)[BOARD_SIZE])boards[b], 3, 0, hints, 3);
+    double hint = (monotonic_seconds() - start) / (BOARDS / 10);
+
+    printf("%-22s %13.0f ns %15.1f us\n", evaluator_name(), eval * 1e9,
+           hint * 1e6);
+  }
+  evaluator_init(EVAL_BEST);
+}
+
+void report(const char *name, int ops, double blocking, double uring) {
+  printf("%-22s %10.0f ops/s", name, ops / blocking);
+  if (uring < 0)
+    printf(" %12s\n", "unavailable");
+  else
+    printf(" %12.0f ops/s  (%.2fx)\n", ops / uring, blocking / uring);
+}
+
+int main(int argc, char *argv[]) {
+  int writers = argc > 1 ? atoi(argv[1]) : MAX_PLAYERS;
+  int lines = argc > 2 ? atoi(argv[2]) : 20000;
+  int prompts = argc > 3 ? atoi(argv[3]) : 50000;
+  int matches = argc > 4 ? atoi(argv[4]) : 200000;
+  int players = argc > 5 ? atoi(argv[5]) : 1000000;
+
+  if (writers < 1 || lines < 1 || prompts < 1 || matches < 1 ||
+      players < MAX_PLAYERS) {
+    printf("Usage: ./bench [writers] [lines_per_writer] [prompts] "
+           "[matches] [players]\n");
+    return 1;
+  }
+
+  double log_blocking = bench_logger(IO_BLOCKING, writers, lines);
+  double log_uring = bench_logger(IO_URING, writers, lines);
+  double prompt_blocking = bench_prompts(IO_BLOCKING, prompts);
+  double prompt_uring = bench_prompts(IO_URING, prompts);
+
+  printf("\n%-22s %16s %18s\n", "case", "blocking", "io_uring");
+  report("log lines", writers * lines, log_blocking, log_uring);
+  report("turn prompts", prompts, prompt_blocking, prompt_uring);
+
+  bench_slab(matches);
+  bench_leaderboard(players);
+  bench_evaluator();
+  return 0;
+}
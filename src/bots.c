@@ -0,0 +1,71 @@
+#include "../include/bots.h"
+#include "../include/evaluator.h"
+#include "../include/game_logic.h"
+#include <time.h>
+
+unsigned int xorshift32(unsigned int *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+unsigned long long digest_add(unsigned long long h, int value) {
+  for (int i = 0; i < 4; i++, value >>= 8)
+    h = (h ^ (value & 0xff)) * 1099511628211ULL; // FNV-1a 64
+  return h;
+}
+
+double monotonic_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int bot_free_cell(const char board[][BOARD_SIZE], int n) {
+  for (int pick = 0;; pick++) {
+    if (board[pick / BOARD_SIZE][pick % BOARD_SIZE] == ' ' && n-- == 0)
+      return pick;
+  }
+}
+
+int bot_move(const char board[][BOARD_SIZE], int player_count, int turn_count,
+             int seat, int greedy_top, unsigned int *rng) {
+  if (greedy_top > 0) {
+    MoveHint hints[HINT_MAX];
+    int n = suggest_moves(board, player_count, seat, hints, greedy_top);
+    if (n > 0) {
+      MoveHint *h = &hints[xorshift32(rng) % n];
+      return h->row * BOARD_SIZE + h->col;
+    }
+  }
+  // Uniform over the free cells
+  int free_cells = BOARD_SIZE * BOARD_SIZE - turn_count;
+  return bot_free_cell(board, xorshift32(rng) % free_cells);
+}
+
+int bot_play_game(MatchSlab *slab, long long id, unsigned int *rng,
+                  unsigned long long *digest) {
+  int slot = match_slab_slot(slab, id);
+  if (slot == -1 || match_slab_reset(slab, id) == -1)
+    return 0;
+  MatchHot *hot = &slab->hot[slot];
+  const char(*board)[BOARD_SIZE] =
+      (const char(*)[BOARD_SIZE])slab->boards[slot];
+  int players = hot->player_count;
+  int greedy_top[MAX_PLAYERS]; // Read once, cold stays out of the loop
+  for (int s = 0; s < players; s++)
+    greedy_top[s] = slab->cold[slot].seats[s].greedy_top;
+
+  int seat = match_slab_next_seat(slab, id, 0);
+  while (seat != -1 && !hot->game_over) {
+    hot->current_player_index = seat;
+    int pick = bot_move(board, players, hot->turn_count, seat,
+                        greedy_top[seat], rng);
+    match_slab_move(slab, id, seat, pick / BOARD_SIZE, pick % BOARD_SIZE);
+    *digest = digest_add(*digest, pick);
+    seat = match_slab_next_seat(slab, id, (seat + 1) % players);
+  }
+  *digest = digest_add(*digest, hot->winner_id);
+  return hot->winner_id;
+}
@@ -1,136 +1,430 @@
 #define _XOPEN_SOURCE 700
 #include "../include/common.h"
+#include <poll.h>
+#include <stdarg.h>
+#include <strings.h>
 #include <unistd.h>
 
-int main(int argc, char *argv[]) {
-  int sock = 0;
-  struct sockaddr_un serv_addr;
-  char buffer[BUFFER_SIZE];
-  char acc_buffer[4096]; // Accumulation buffer
-  int acc_len = 0;
+char session_token[TOKEN_LEN] = ""; // From the server's SESSION line
+char server_host[64] = "";          // --connect host (empty: SOCKET_PATH)
+char server_port[8] = "";
+char player_name[NAME_LEN] = ""; // --name, for rated play
+
+// Screen layout: title, column header, the board rows, then three lines
+// below it. Cells are redrawn in place, so a move costs a few bytes of
+// terminal output instead of a full board.
+#define ROW_TITLE 1
+#define ROW_BOARD 3 // Screen row of board row 0
+#define ROW_INFO (ROW_BOARD + BOARD_SIZE + 1)
+#define ROW_STATUS (ROW_INFO + 1)
+#define ROW_PROMPT (ROW_STATUS + 1)
+#define CELL_COL(c) (5 + 3 * (c)) // Screen column of the symbol in "[x]"
+
+#define HINT_COUNT 3 // Moves asked for when the player types "hint"
 
-  if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
-    printf("\n Socket creation error \n");
+char board[BOARD_SIZE][BOARD_SIZE];  // Board being received (BOARD..END)
+char screen[BOARD_SIZE][BOARD_SIZE]; // What the terminal shows
+char board_title[64];
+char screen_title[64];
+int board_row = -1; // Next board row to parse, -1 outside a BOARD block
+int drawn = 0;      // Board is on screen; lines below it are addressable
+int my_turn = 0;
+char info_line[128] = "";
+
+int connect_tcp() {
+  struct addrinfo hints, *res, *ai;
+  int sock = -1;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(server_host, server_port, &hints, &res) != 0)
     return -1;
+
+  for (ai = res; ai; ai = ai->ai_next) {
+    sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (sock < 0)
+      continue;
+    if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+      break;
+    close(sock);
+    sock = -1;
   }
+  freeaddrinfo(res);
 
-  memset(&serv_addr, 0, sizeof(serv_addr));
-  serv_addr.sun_family = AF_UNIX;
-  strncpy(serv_addr.sun_path, SOCKET_PATH, sizeof(serv_addr.sun_path) - 1);
+  if (sock >= 0) {
+    int one = 1; // Moves are tiny; don't let Nagle hold them back
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  return sock;
+}
 
-  if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
-    perror("Connection Failed");
+// Connects and introduces ourselves: RESUME with a token, JOIN otherwise
+int connect_server() {
+  int sock;
+  struct sockaddr_un serv_addr;
+
+  if (server_host[0]) {
+    if ((sock = connect_tcp()) < 0)
+      return -1;
+  } else {
+    if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+      printf("\n Socket creation error \n");
+      return -1;
+    }
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sun_family = AF_UNIX;
+    strncpy(serv_addr.sun_path, SOCKET_PATH, sizeof(serv_addr.sun_path) - 1);
+
+    if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+      close(sock);
+      return -1;
+    }
+  }
+
+  char hello[64];
+  if (session_token[0])
+    snprintf(hello, sizeof(hello), "RESUME %s\n", session_token);
+  else if (player_name[0])
+    snprintf(hello, sizeof(hello), "JOIN %s\n", player_name);
+  else
+    snprintf(hello, sizeof(hello), "JOIN\n");
+  send(sock, hello, strlen(hello), 0);
+  return sock;
+}
+
+// Tries to get our seat back while the server still holds it
+int reconnect_server() {
+  if (!session_token[0])
     return -1;
+  printf("\nConnection lost. Reconnecting...\n");
+  for (int i = 0; i < SESSION_GRACE_SEC; i++) {
+    sleep(1);
+    int sock = connect_server();
+    if (sock >= 0)
+      return sock;
   }
+  return -1;
+}
 
-  printf("Connected to Mega Tic-Tac-Toe Server at %s\n", SOCKET_PATH);
-  printf("Waiting for game to start...\n");
+// Writes text on one of the lines below the board without moving the
+// cursor away from what the player is typing. Before the first board it
+// just prints a line.
+void show_line(int row, const char *format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
 
-  memset(acc_buffer, 0, sizeof(acc_buffer));
+  if (drawn)
+    printf("\0337\033[%d;1H\033[K%s\0338", row, text);
+  else
+    printf("%s\n", text);
+}
 
-  while (1) {
-    memset(buffer, 0, BUFFER_SIZE);
-    int valread = recv(sock, buffer, BUFFER_SIZE - 1, 0);
-    if (valread <= 0) {
-      printf("Server disconnected.\n");
-      break;
+void show_prompt() {
+  if (drawn)
+    printf("\033[%d;1H\033[J", ROW_PROMPT);
+  else
+    printf("\n");
+  printf("Your Turn! Enter Row and Col (e.g., 5 5) or 'hint': ");
+}
+
+void draw_full() {
+  printf("\033[H\033[J%s\n   ", board_title);
+  for (int c = 0; c < BOARD_SIZE; c++)
+    printf("%2d ", c);
+  printf("\n");
+  for (int r = 0; r < BOARD_SIZE; r++) {
+    printf("%2d ", r);
+    for (int c = 0; c < BOARD_SIZE; c++)
+      printf("[%c]", board[r][c]);
+    printf("\n");
+  }
+  memcpy(screen, board, sizeof(screen));
+  memcpy(screen_title, board_title, sizeof(screen_title));
+  drawn = 1;
+  if (info_line[0])
+    show_line(ROW_INFO, "%s", info_line);
+}
+
+// A complete board arrived: touch only the cells that changed
+void draw_board() {
+  if (!drawn) {
+    draw_full();
+    return;
+  }
+  printf("\0337");
+  if (strcmp(screen_title, board_title) != 0) {
+    printf("\033[%d;1H\033[K%s", ROW_TITLE, board_title);
+    memcpy(screen_title, board_title, sizeof(screen_title));
+  }
+  for (int r = 0; r < BOARD_SIZE; r++) {
+    for (int c = 0; c < BOARD_SIZE; c++) {
+      if (screen[r][c] == board[r][c])
+        continue;
+      printf("\033[%d;%dH%c", ROW_BOARD + r, CELL_COL(c), board[r][c]);
+      screen[r][c] = board[r][c];
     }
+  }
+  printf("\0338");
+}
+
+// Board rows look like "%2d [X][ ][O]..."
+void parse_board_row(const char *line) {
+  int r;
+  const char *cells = strchr(line, '[');
+  if (sscanf(line, "%d", &r) != 1 || r != board_row || !cells)
+    return;
+  for (int c = 0; c < BOARD_SIZE && cells[0] == '['; c++, cells += 3)
+    board[r][c] = cells[1] ? cells[1] : ' ';
+  board_row++;
+}
 
-    // Handle Immediate Commands (Small packets like INVALID or GAME_OVER might
-    // come alone or mixed) Simplified Logic: Determine type by prefix. But
-    // framing means we should buffer everything until delimiters. However,
-    // GAME_OVER and INVALID often come alone.
-
-    // Append to accumulation buffer
-    if (acc_len + valread < sizeof(acc_buffer)) {
-      memcpy(acc_buffer + acc_len, buffer, valread);
-      acc_len += valread;
-      acc_buffer[acc_len] = '\0';
-      // printf("[DEBUG-CLIENT] Recv %d bytes. Buffer: %s\n", valread,
-      // acc_buffer);
+// Handles one server line. Returns 0 when the client should quit, -1 when
+// it has to switch to another server, 1 otherwise.
+int handle_line(char *line, char *redirect_host, int *redirect_port) {
+  int value;
+
+  if (board_row >= 0) {
+    if (strcmp(line, "END") == 0) {
+      board_row = -1;
+      draw_board();
+    } else if (strchr(line, '[')) {
+      parse_board_row(line); // The column header has no cells
+    }
+    return 1;
+  }
+
+  if (strncmp(line, "BOARD", 5) == 0) {
+    snprintf(board_title, sizeof(board_title), "%s", line);
+    board_row = 0;
+  } else if (strcmp(line, "YOUR_TURN") == 0) {
+    my_turn = 1;
+    show_prompt();
+  } else if (strncmp(line, "HINTS", 5) == 0) {
+    // "HINTS r c score ..." -> "Hints: 5 6 (120), ..."
+    char text[128] = "Hints:";
+    int len = strlen(text), r, c, score, used;
+    for (const char *p = line + 5;
+         sscanf(p, "%d %d %d%n", &r, &c, &score, &used) == 3; p += used)
+      len += snprintf(text + len, sizeof(text) - len, "%s %d %d (%d)",
+                      len > 6 ? "," : "", r, c, score);
+    show_line(ROW_STATUS, "%s", len > 6 ? text : "No moves left to suggest.");
+  } else if (sscanf(line, "PREMOVES %d", &value) == 1) {
+    if (value > 0)
+      show_line(ROW_STATUS, "Premoves queued: %d ('clear' drops them).", value);
+    else
+      show_line(ROW_STATUS, "No premoves queued.");
+  } else if (strncmp(line, "PREMOVED ", 9) == 0) {
+    show_line(ROW_STATUS, "Premove %s played.", line + 9);
+  } else if (strncmp(line, "PREMOVE_FAILED ", 15) == 0) {
+    show_line(ROW_STATUS, "Premove %s was taken; premoves cleared.",
+              line + 15);
+  } else if (strcmp(line, "INVALID") == 0) {
+    show_line(ROW_STATUS, "Invalid Move! Try again.");
+  } else if (sscanf(line, "GAME_OVER %d", &value) == 1) {
+    my_turn = 0;
+    if (value == 0)
+      show_line(ROW_STATUS, "--- GAME OVER: DRAW --- Waiting for next game...");
+    else
+      show_line(ROW_STATUS,
+                "--- GAME OVER: Player %d WINS! --- Waiting for next game...",
+                value);
+  } else if (strncmp(line, "SESSION ", 8) == 0) {
+    // Session handshake: remember the token for reconnects
+    if (sscanf(line, "SESSION %16s %d", session_token, &value) == 2) {
+      int len = snprintf(info_line, sizeof(info_line),
+                         "You are Player %d. To rejoin: ./client ", value);
+      if (server_host[0])
+        len += snprintf(info_line + len, sizeof(info_line) - len,
+                        "--connect %s:%s ", server_host, server_port);
+      snprintf(info_line + len, sizeof(info_line) - len, "%s", session_token);
+      show_line(ROW_INFO, "%s", info_line);
+    }
+  } else if (strcmp(line, "FULL") == 0 || strcmp(line, "REJECTED") == 0) {
+    show_line(ROW_STATUS,
+              "Server refused the connection: game full or session expired.");
+    return 0;
+  } else if (strcmp(line, "NAME_TAKEN") == 0 || strcmp(line, "BADNAME") == 0) {
+    show_line(ROW_STATUS, "Server refused the name '%s': %s.", player_name,
+              line[0] == 'N' ? "already playing" : "use A-Z a-z 0-9 _ - .");
+    return 0;
+  } else if (sscanf(line, "REDIRECT %63s %d", redirect_host, redirect_port) ==
+             2) {
+    // A gateway sends us on to the backend that hosts our match
+    return -1;
+  }
+  return 1;
+}
+
+// Acts on one line the player typed (without its newline)
+void handle_input(int sock, const char *input) {
+  char request[80];
+  int row, col;
+
+  if (my_turn && strncasecmp(input, "hint", 4) == 0) {
+    // Keeps the turn; the answer comes back as a HINTS line
+    snprintf(request, sizeof(request), "HINT %d\n", HINT_COUNT);
+    send(sock, request, strlen(request), 0);
+    show_prompt();
+  } else if (my_turn) {
+    snprintf(request, sizeof(request), "%s\n", input);
+    send(sock, request, strlen(request), 0);
+    my_turn = 0;
+    show_line(ROW_STATUS, "Move sent. Waiting for other players...");
+  } else if (sscanf(input, "%d %d", &row, &col) == 2) {
+    // Queued on the server and played the moment the turn comes
+    snprintf(request, sizeof(request), "PRE %d %d\n", row, col);
+    send(sock, request, strlen(request), 0);
+  } else if (strncasecmp(input, "clear", 5) == 0) {
+    send(sock, "PRE CLEAR\n", 10, 0);
+  } else {
+    show_line(ROW_STATUS, "Not your turn yet.");
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int sock = 0;
+  char acc_buffer[4096]; // Accumulation buffer for partial lines
+  int acc_len = 0;
+  char input[64];
+  int input_len = 0;
+  int stdin_open = 1;
+
+  signal(SIGPIPE, SIG_IGN); // A dead server shows up as a failed recv
+
+  // ./client [--connect host:port] [--name name] [token]
+  // A token rejoins the seat of an earlier session; a name plays rated.
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+      char *colon = strrchr(argv[++i], ':');
+      snprintf(server_port, sizeof(server_port), "%d",
+               colon ? atoi(colon + 1) : GATEWAY_PORT);
+      if (colon)
+        *colon = '\0';
+      strncpy(server_host, argv[i], sizeof(server_host) - 1);
+    } else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+      strncpy(player_name, argv[++i], sizeof(player_name) - 1);
     } else {
-      // Buffer overflow safety
-      acc_len = 0;
-      memset(acc_buffer, 0, sizeof(acc_buffer));
-      printf("Error: Message too large.\n");
+      strncpy(session_token, argv[i], sizeof(session_token) - 1);
     }
+  }
 
-    // Check for Markers
-    char *end_ptr = strstr(acc_buffer, "END\n");
-    char *game_over_ptr = strstr(acc_buffer, "GAME_OVER");
-    char *invalid_ptr = strstr(acc_buffer, "INVALID");
-    char *turn_ptr = strstr(acc_buffer, "YOUR_TURN");
-
-    if (end_ptr)
-      printf("[DEBUG-CLIENT] Found END\n");
-    if (turn_ptr)
-      printf("[DEBUG-CLIENT] Found YOUR_TURN\n");
-
-    if (game_over_ptr) {
-      // Check if we have a final board update pending before the Game Over msg
-      if (end_ptr && end_ptr < game_over_ptr) {
-        *end_ptr = '\0';
-        printf("\033[H\033[J");
-        printf("%s", acc_buffer);
-      }
+  if ((sock = connect_server()) < 0) {
+    perror("Connection Failed");
+    return -1;
+  }
+
+  if (server_host[0])
+    printf("Connected to Mega Tic-Tac-Toe Server at %s:%s\n", server_host,
+           server_port);
+  else
+    printf("Connected to Mega Tic-Tac-Toe Server at %s\n", SOCKET_PATH);
+  printf("Waiting for game to start...\n");
+  fflush(stdout);
 
-      int winner_id;
-      sscanf(game_over_ptr, "GAME_OVER %d", &winner_id);
-      if (winner_id == 0) {
-        printf("\n--- GAME OVER: DRAW ---\n");
+  // One loop serves the server and the keyboard, so board updates keep
+  // arriving while the player is typing.
+  while (1) {
+    struct pollfd fds[2] = {{.fd = sock, .events = POLLIN},
+                            {.fd = stdin_open ? 0 : -1, .events = POLLIN}};
+    if (poll(fds, 2, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      perror("poll");
+      break;
+    }
+
+    if (fds[1].revents & (POLLIN | POLLHUP)) {
+      ssize_t n = read(0, input + input_len, sizeof(input) - 1 - input_len);
+      if (n <= 0) {
+        stdin_open = 0; // Keep spectating without a keyboard
       } else {
-        printf("\n--- GAME OVER: Player %d WINS! ---\n", winner_id);
+        input_len += n;
+        input[input_len] = '\0';
+        // Act on each complete line, like the server's; keep the partial
+        // tail. Once a move is sent, the lines after it queue as premoves.
+        char *line = input;
+        char *nl;
+        while ((nl = memchr(line, '\n', input + input_len - line))) {
+          *nl = '\0';
+          handle_input(sock, line);
+          line = nl + 1;
+        }
+        input_len -= line - input;
+        memmove(input, line, input_len + 1);
+        if (input_len == sizeof(input) - 1) {
+          handle_input(sock, input); // As typed; no line of ours is this long
+          input_len = 0;
+        }
       }
-      // break; // Removed to support multi-game.
-      // Reset buffer for next game
-      memset(acc_buffer, 0, sizeof(acc_buffer));
-      acc_len = 0;
-      printf("Waiting for next game...\n");
     }
 
-    if (invalid_ptr) {
-      printf("Invalid Move! Try again (Row Col): ");
-      // Reset buffer after handling
-      memset(acc_buffer, 0, sizeof(acc_buffer));
-      acc_len = 0;
-      // Get Input immediately
-      char input[64];
-      if (fgets(input, sizeof(input), stdin) != NULL) {
-        send(sock, input, strlen(input), 0);
-      }
+    if (!(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+      fflush(stdout);
       continue;
     }
 
-    if (end_ptr) {
-      // Cut the string at END
-      *end_ptr = '\0';
-
-      // Clear Screen
-      printf("\033[H\033[J");
-
-      // Print Board
-      printf("%s", acc_buffer);
-
-      // Reset Buffer
-      memset(acc_buffer, 0, sizeof(acc_buffer));
+    int valread = recv(sock, acc_buffer + acc_len,
+                       sizeof(acc_buffer) - 1 - acc_len, 0);
+    if (valread <= 0) {
+      close(sock);
+      my_turn = 0;
+      show_line(ROW_STATUS, "Connection lost. Reconnecting...");
+      fflush(stdout);
+      if ((sock = reconnect_server()) < 0) {
+        show_line(ROW_STATUS, "Server disconnected.");
+        if (drawn)
+          printf("\033[%d;1H\033[J", ROW_PROMPT);
+        return 0;
+      }
       acc_len = 0;
+      board_row = -1;
+      continue;
     }
+    acc_len += valread;
 
-    if (turn_ptr) {
-      printf("[DEBUG-CLIENT] Processing YOUR_TURN prompt...\n");
-      printf("\nYour Turn! Enter Row and Col (e.g., 5 5): ");
-      memset(acc_buffer, 0, sizeof(acc_buffer)); // Clear command from buffer
-      acc_len = 0;
+    // Hand each complete line to the parser; keep the partial tail
+    char *line = acc_buffer;
+    char *nl;
+    int result = 1;
+    char redirect_host[64];
+    int redirect_port;
+    while (result == 1 &&
+           (nl = memchr(line, '\n', acc_buffer + acc_len - line))) {
+      *nl = '\0';
+      result = handle_line(line, redirect_host, &redirect_port);
+      line = nl + 1;
+    }
+    acc_len -= line - acc_buffer;
+    memmove(acc_buffer, line, acc_len);
+    if (acc_len == sizeof(acc_buffer) - 1) {
+      acc_len = 0; // A line this long is not ours
+      show_line(ROW_STATUS, "Error: Message too large.");
+    }
+    fflush(stdout);
 
-      // Get Input
-      char input[64];
-      if (fgets(input, sizeof(input), stdin) != NULL) {
-        send(sock, input, strlen(input), 0);
-        printf("Move sent. Waiting for other players...\n");
+    if (result == 0)
+      break;
+    if (result == -1) {
+      close(sock);
+      strncpy(server_host, redirect_host, sizeof(server_host) - 1);
+      snprintf(server_port, sizeof(server_port), "%d", redirect_port);
+      if ((sock = connect_server()) < 0) {
+        perror("Redirect Failed");
+        return -1;
       }
+      printf("Match assigned on %s:%s\n", server_host, server_port);
+      fflush(stdout);
+      acc_len = 0;
     }
   }
 
+  if (drawn)
+    printf("\033[%d;1H\033[J", ROW_PROMPT);
   close(sock);
   return 0;
 }
@@ -0,0 +1,349 @@
+#include "../include/evaluator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+// The board and its transpose, 16 lanes per row. Walking rows with the
+// previous row's lanes shifted covers all four directions:
+//   vertical   BOARD, SHIFT_NONE       diagonal \  BOARD, SHIFT_LEFT
+//   horizontal TRANSPOSED, SHIFT_NONE  diagonal /  BOARD, SHIFT_RIGHT
+// Lanes past the board and the extra last row are 0, a wall that is
+// neither a stone nor empty; the last row also ends every open run.
+#define EVAL_ROWS (BOARD_SIZE + 1)
+#define ORIENT_BOARD 0
+#define ORIENT_TRANSPOSED 1
+
+#define SHIFT_NONE 0
+#define SHIFT_LEFT 1  // Lane c continues from lane c - 1
+#define SHIFT_RIGHT 2 // Lane c continues from lane c + 1
+
+typedef struct {
+  unsigned char rows[2][EVAL_ROWS][16];
+} __attribute__((aligned(32))) EvalBoard;
+
+// Run weights by length and open ends (0, 1 or 2)
+#define W2_OPEN1 2
+#define W2_OPEN2 6
+#define W3_OPEN1 8
+#define W3_OPEN2 30
+#define W4_OPEN1 40
+#define W4_OPEN2 120
+
+static int backend = EVAL_SCALAR;
+static int (*eval_fn)(const EvalBoard *eb, char symbol);
+
+static void set_cell(EvalBoard *eb, int r, int c, char v) {
+  eb->rows[ORIENT_BOARD][r][c] = v;
+  eb->rows[ORIENT_TRANSPOSED][c][r] = v;
+}
+
+static void load_board(EvalBoard *eb, const char board[][BOARD_SIZE]) {
+  unsigned char(*rows)[16] = eb->rows[ORIENT_BOARD];
+  memset(eb, 0, sizeof(*eb));
+  for (int r = 0; r < BOARD_SIZE; r++)
+    memcpy(rows[r], board[r], BOARD_SIZE);
+
+#ifdef HAVE_X86_SIMD
+  // 16x16 byte transpose: four rounds of interleaving row pairs
+  __m128i a[16], b[16];
+  for (int i = 0; i < 16; i++)
+    a[i] = _mm_load_si128((const __m128i *)rows[i < EVAL_ROWS ? i : 0]);
+  for (int i = EVAL_ROWS; i < 16; i++)
+    a[i] = _mm_setzero_si128();
+  for (int i = 0; i < 8; i++) {
+    b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+    b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+  }
+  for (int i = 0; i < 8; i++) {
+    a[2 * i] = _mm_unpacklo_epi8(b[i], b[i + 8]);
+    a[2 * i + 1] = _mm_unpackhi_epi8(b[i], b[i + 8]);
+  }
+  for (int i = 0; i < 8; i++) {
+    b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+    b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+  }
+  for (int i = 0; i < 8; i++) {
+    a[2 * i] = _mm_unpacklo_epi8(b[i], b[i + 8]);
+    a[2 * i + 1] = _mm_unpackhi_epi8(b[i], b[i + 8]);
+  }
+  for (int i = 0; i < BOARD_SIZE; i++)
+    _mm_store_si128((__m128i *)eb->rows[ORIENT_TRANSPOSED][i], a[i]);
+#else
+  for (int r = 0; r < BOARD_SIZE; r++) {
+    for (int c = 0; c < BOARD_SIZE; c++)
+      eb->rows[ORIENT_TRANSPOSED][c][r] = board[r][c];
+  }
+#endif
+}
+
+// --- Scalar reference ---
+
+static int run_score(int len, int opens) {
+  static const int weights[WIN_COUNT][3] = {
+      {0, 0, 0},
+      {0, 0, 0},
+      {0, W2_OPEN1, W2_OPEN2},
+      {0, W3_OPEN1, W3_OPEN2},
+      {0, W4_OPEN1, W4_OPEN2},
+  };
+  return len >= WIN_COUNT ? EVAL_WIN_RUN : weights[len][opens];
+}
+
+// One direction. Per lane: len is the run ending on the previous row, open
+// whether the cell before it was empty. A run is scored on the row where it
+// stops.
+static int scan_scalar(const unsigned char rows[][16], char symbol,
+                       int shift) {
+  unsigned char len[16] = {0}, open[16] = {0}, empty[16] = {0};
+  int score = 0;
+
+  for (int r = 0; r < EVAL_ROWS; r++) {
+    unsigned char next_len[16], next_open[16], next_empty[16];
+    for (int c = 0; c < 16; c++) {
+      int src = shift == SHIFT_LEFT ? c - 1 : shift == SHIFT_RIGHT ? c + 1 : c;
+      int inside = src >= 0 && src < 16;
+      int prev_len = inside ? len[src] : 0;
+      int prev_open = inside ? open[src] : 0;
+      int prev_empty = inside ? empty[src] : 0;
+      int mine = rows[r][c] == symbol;
+      next_empty[c] = rows[r][c] == ' ';
+
+      if (prev_len && !mine)
+        score += run_score(prev_len, prev_open + next_empty[c]);
+      next_len[c] = mine ? prev_len + 1 : 0;
+      next_open[c] = mine && (prev_len ? prev_open : prev_empty);
+    }
+    memcpy(len, next_len, 16);
+    memcpy(open, next_open, 16);
+    memcpy(empty, next_empty, 16);
+  }
+  return score;
+}
+
+static int eval_scalar(const EvalBoard *eb, char symbol) {
+  return scan_scalar(eb->rows[ORIENT_BOARD], symbol, SHIFT_NONE) +
+         scan_scalar(eb->rows[ORIENT_TRANSPOSED], symbol, SHIFT_NONE) +
+         scan_scalar(eb->rows[ORIENT_BOARD], symbol, SHIFT_LEFT) +
+         scan_scalar(eb->rows[ORIENT_BOARD], symbol, SHIFT_RIGHT);
+}
+
+#ifdef HAVE_X86_SIMD
+
+// --- SSE2: the scalar recurrence, 16 lanes at a time ---
+
+static inline __attribute__((always_inline)) int
+scan_sse2(const unsigned char rows[][16], char symbol, int shift) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi8(-1);
+  const __m128i one = _mm_set1_epi8(1), two = _mm_set1_epi8(2);
+  const __m128i three = _mm_set1_epi8(3), four = _mm_set1_epi8(4);
+  const __m128i sym = _mm_set1_epi8(symbol), space = _mm_set1_epi8(' ');
+  __m128i len = zero, open = zero, empty = zero, acc = zero;
+
+  for (int r = 0; r < EVAL_ROWS; r++) {
+    __m128i row = _mm_load_si128((const __m128i *)rows[r]);
+    __m128i mine = _mm_cmpeq_epi8(row, sym);
+    __m128i here_empty = _mm_cmpeq_epi8(row, space);
+    __m128i prev_len = len, prev_open = open, prev_empty = empty;
+    if (shift == SHIFT_LEFT) {
+      prev_len = _mm_slli_si128(len, 1);
+      prev_open = _mm_slli_si128(open, 1);
+      prev_empty = _mm_slli_si128(empty, 1);
+    } else if (shift == SHIFT_RIGHT) {
+      prev_len = _mm_srli_si128(len, 1);
+      prev_open = _mm_srli_si128(open, 1);
+      prev_empty = _mm_srli_si128(empty, 1);
+    }
+
+    __m128i no_run = _mm_cmpeq_epi8(prev_len, zero);
+    __m128i ends = _mm_andnot_si128(_mm_or_si128(no_run, mine), ones);
+    __m128i opens = _mm_add_epi8(prev_open, _mm_and_si128(here_empty, one));
+    __m128i open1 = _mm_cmpeq_epi8(opens, one);
+    __m128i open2 = _mm_cmpeq_epi8(opens, two);
+
+    __m128i s2 = _mm_or_si128(_mm_and_si128(open1, _mm_set1_epi8(W2_OPEN1)),
+                              _mm_and_si128(open2, _mm_set1_epi8(W2_OPEN2)));
+    __m128i s3 = _mm_or_si128(_mm_and_si128(open1, _mm_set1_epi8(W3_OPEN1)),
+                              _mm_and_si128(open2, _mm_set1_epi8(W3_OPEN2)));
+    __m128i s4 = _mm_or_si128(_mm_and_si128(open1, _mm_set1_epi8(W4_OPEN1)),
+                              _mm_and_si128(open2, _mm_set1_epi8(W4_OPEN2)));
+    __m128i score =
+        _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(prev_len, two), s2),
+                     _mm_and_si128(_mm_cmpeq_epi8(prev_len, three), s3));
+    score = _mm_or_si128(score,
+                         _mm_and_si128(_mm_cmpeq_epi8(prev_len, four), s4));
+    score = _mm_or_si128(score, _mm_and_si128(_mm_cmpgt_epi8(prev_len, four),
+                                              _mm_set1_epi8(EVAL_WIN_RUN)));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_and_si128(score, ends), zero));
+
+    __m128i continues = _mm_andnot_si128(no_run, prev_open);
+    __m128i starts = _mm_and_si128(no_run, _mm_and_si128(prev_empty, one));
+    len = _mm_and_si128(_mm_add_epi8(prev_len, one), mine);
+    open = _mm_and_si128(mine, _mm_or_si128(continues, starts));
+    empty = here_empty;
+  }
+  return _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+}
+
+static int eval_sse2(const EvalBoard *eb, char symbol) {
+  return scan_sse2(eb->rows[ORIENT_BOARD], symbol, SHIFT_NONE) +
+         scan_sse2(eb->rows[ORIENT_TRANSPOSED], symbol, SHIFT_NONE) +
+         scan_sse2(eb->rows[ORIENT_BOARD], symbol, SHIFT_LEFT) +
+         scan_sse2(eb->rows[ORIENT_BOARD], symbol, SHIFT_RIGHT);
+}
+
+// --- AVX2: two directions per step, one in each 128-bit half ---
+// (vertical with horizontal, then the two diagonals on the same rows)
+// Scoring is one table lookup: open is kept as 0 or 5, so
+// min(len, 5) - 1 + 5 * open_ends indexes run_table (0 below length 2).
+
+__attribute__((target("avx2"))) static inline int
+scan_avx2(const unsigned char lo[][16], const unsigned char hi[][16],
+          char symbol, int diagonals) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi8(1), five = _mm256_set1_epi8(5);
+  const __m256i sym = _mm256_set1_epi8(symbol);
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i run_table = _mm256_setr_epi8(
+      0, 0, 0, 0, EVAL_WIN_RUN, 0, W2_OPEN1, W3_OPEN1, W4_OPEN1, EVAL_WIN_RUN,
+      0, W2_OPEN2, W3_OPEN2, W4_OPEN2, EVAL_WIN_RUN, 0, 0, 0, 0, 0,
+      EVAL_WIN_RUN, 0, W2_OPEN1, W3_OPEN1, W4_OPEN1, EVAL_WIN_RUN, 0, W2_OPEN2,
+      W3_OPEN2, W4_OPEN2, EVAL_WIN_RUN, 0);
+  __m256i len = zero, open = zero, empty = zero, acc = zero;
+
+  for (int r = 0; r < EVAL_ROWS; r++) {
+    __m256i row = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_load_si128((const __m128i *)lo[r])),
+        _mm_load_si128((const __m128i *)hi[r]), 1);
+    __m256i mine = _mm256_cmpeq_epi8(row, sym);
+    __m256i here_empty = _mm256_and_si256(_mm256_cmpeq_epi8(row, space), five);
+    __m256i prev_len = len, prev_open = open, prev_empty = empty;
+    if (diagonals) { // Low half shifts left, high half right
+      prev_len = _mm256_blend_epi32(_mm256_slli_si256(len, 1),
+                                    _mm256_srli_si256(len, 1), 0xF0);
+      prev_open = _mm256_blend_epi32(_mm256_slli_si256(open, 1),
+                                     _mm256_srli_si256(open, 1), 0xF0);
+      prev_empty = _mm256_blend_epi32(_mm256_slli_si256(empty, 1),
+                                      _mm256_srli_si256(empty, 1), 0xF0);
+    }
+
+    // Runs that stop here: look up length and open ends
+    __m256i index = _mm256_subs_epu8(_mm256_min_epu8(prev_len, five), one);
+    index = _mm256_add_epi8(index, _mm256_add_epi8(prev_open, here_empty));
+    __m256i score =
+        _mm256_andnot_si256(mine, _mm256_shuffle_epi8(run_table, index));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(score, zero));
+
+    __m256i no_run = _mm256_cmpeq_epi8(prev_len, zero);
+    open = _mm256_and_si256(mine, _mm256_blendv_epi8(prev_open, prev_empty,
+                                                     no_run));
+    len = _mm256_and_si256(_mm256_add_epi8(prev_len, one), mine);
+    empty = here_empty;
+  }
+  __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                              _mm256_extracti128_si256(acc, 1));
+  return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+}
+
+__attribute__((target("avx2"))) static int eval_avx2(const EvalBoard *eb,
+                                                     char symbol) {
+  return scan_avx2(eb->rows[ORIENT_BOARD], eb->rows[ORIENT_TRANSPOSED], symbol,
+                   0) +
+         scan_avx2(eb->rows[ORIENT_BOARD], eb->rows[ORIENT_BOARD], symbol, 1);
+}
+
+#endif // HAVE_X86_SIMD
+
+int evaluator_init(int wanted) {
+  backend = EVAL_SCALAR;
+  eval_fn = eval_scalar;
+#ifdef HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (wanted != EVAL_SCALAR) {
+    backend = EVAL_SSE2; // Baseline on x86-64
+    eval_fn = eval_sse2;
+  }
+  if ((wanted == EVAL_BEST || wanted == EVAL_AVX2) &&
+      __builtin_cpu_supports("avx2")) {
+    backend = EVAL_AVX2;
+    eval_fn = eval_avx2;
+  }
+#else
+  (void)wanted;
+#endif
+  return backend;
+}
+
+const char *evaluator_name(void) {
+  const char *names[] = {"scalar", "sse2", "avx2"};
+  if (!eval_fn)
+    evaluator_init(EVAL_BEST);
+  return names[backend];
+}
+
+int evaluate_symbol(const char board[][BOARD_SIZE], char symbol) {
+  EvalBoard eb;
+  if (!eval_fn)
+    evaluator_init(EVAL_BEST);
+  load_board(&eb, board);
+  return eval_fn(&eb, symbol);
+}
+
+void evaluate_position(const char board[][BOARD_SIZE], int players,
+                       int *scores) {
+  EvalBoard eb;
+  if (!eval_fn)
+    evaluator_init(EVAL_BEST);
+  load_board(&eb, board);
+  for (int i = 0; i < players; i++)
+    scores[i] = eval_fn(&eb, PLAYER_SYMBOLS[i]);
+}
+
+int suggest_moves(const char board[][BOARD_SIZE], int players, int seat,
+                  MoveHint *out, int n) {
+  EvalBoard eb;
+  int base[MAX_PLAYERS];
+  int count = 0;
+
+  if (!eval_fn)
+    evaluator_init(EVAL_BEST);
+  load_board(&eb, board);
+  for (int i = 0; i < players; i++)
+    base[i] = eval_fn(&eb, PLAYER_SYMBOLS[i]);
+
+  for (int r = 0; r < BOARD_SIZE; r++) {
+    for (int c = 0; c < BOARD_SIZE; c++) {
+      if (board[r][c] != ' ')
+        continue;
+
+      // Own gain counts double so a win beats blocking one
+      int score = 0, threat = 0;
+      for (int i = 0; i < players; i++) {
+        set_cell(&eb, r, c, PLAYER_SYMBOLS[i]);
+        int gain = eval_fn(&eb, PLAYER_SYMBOLS[i]) - base[i];
+        if (i == seat)
+          score += 2 * gain;
+        else if (gain > threat)
+          threat = gain;
+      }
+      set_cell(&eb, r, c, ' ');
+      score += threat;
+
+      // Insert into the sorted top n; ties keep board order
+      int pos = count < n ? count++ : n;
+      while (pos > 0 && out[pos - 1].score < score) {
+        if (pos < n)
+          out[pos] = out[pos - 1];
+        pos--;
+      }
+      if (pos < n) {
+        out[pos].row = r;
+        out[pos].col = c;
+        out[pos].score = score;
+      }
+    }
+  }
+  return count;
+}
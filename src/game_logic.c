@@ -1,25 +1,29 @@
-#include "../include/common.h"
+#include "../include/game_logic.h"
 
 void init_game_state(GameState *gs) {
+  gs->magic = STATE_MAGIC;
+  gs->version = STATE_VERSION;
   memset((void *)gs->board, ' ', sizeof(gs->board));
   gs->player_count = 0;
   gs->current_player_index = 0;
   gs->game_over = 0;
   gs->winner_id = 0;
   gs->turn_count = 0;
+  gs->result_saved = 0;
 }
 
-int is_valid_move(GameState *gs, int row, int col) {
+int board_is_valid_move(const char board[][BOARD_SIZE], int row, int col) {
   if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
     return 0; // Out of bounds
   }
-  if (gs->board[row][col] != ' ') {
+  if (board[row][col] != ' ') {
     return 0; // Already occupied
   }
   return 1;
 }
 
-int check_win(GameState *gs, int row, int col, char symbol) {
+int board_check_win(const char board[][BOARD_SIZE], int row, int col,
+                    char symbol) {
   // Check 4 directions: Horizontal, Vertical, Diagonal 1 (\), Diagonal 2 (/)
   int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
 
@@ -33,7 +37,7 @@ int check_win(GameState *gs, int row, int col, char symbol) {
       int r = row + i * dr;
       int c = col + i * dc;
       if (r >= 0 && r < BOARD_SIZE && c >= 0 && c < BOARD_SIZE &&
-          gs->board[r][c] == symbol) {
+          board[r][c] == symbol) {
         count++;
       } else {
         break;
@@ -45,7 +49,7 @@ int check_win(GameState *gs, int row, int col, char symbol) {
       int r = row - i * dr;
       int c = col - i * dc;
       if (r >= 0 && r < BOARD_SIZE && c >= 0 && c < BOARD_SIZE &&
-          gs->board[r][c] == symbol) {
+          board[r][c] == symbol) {
         count++;
       } else {
         break;
@@ -59,9 +63,60 @@ int check_win(GameState *gs, int row, int col, char symbol) {
   return 0;
 }
 
+// The GameState board is only read under game_mutex, so dropping volatile
+// for the shared rules is safe.
+int is_valid_move(GameState *gs, int row, int col) {
+  return board_is_valid_move((const char(*)[BOARD_SIZE])gs->board, row, col);
+}
+
+int check_win(GameState *gs, int row, int col, char symbol) {
+  return board_check_win((const char(*)[BOARD_SIZE])gs->board, row, col,
+                         symbol);
+}
+
 int is_board_full(GameState *gs) {
   if (gs->turn_count >= BOARD_SIZE * BOARD_SIZE) {
     return 1;
   }
   return 0;
 }
+
+int apply_move(GameState *gs, int seat, int row, int col) {
+  char symbol = gs->players[seat].symbol;
+  if (!is_valid_move(gs, row, col))
+    return MOVE_INVALID;
+
+  gs->board[row][col] = symbol;
+  gs->turn_count++;
+  if (check_win(gs, row, col, symbol)) {
+    gs->game_over = 1;
+    gs->winner_id = seat + 1;
+    return MOVE_WIN;
+  }
+  if (is_board_full(gs)) {
+    gs->game_over = 1;
+    gs->winner_id = 0; // Draw
+    return MOVE_DRAW;
+  }
+  return MOVE_PLACED;
+}
+
+int next_seat(GameState *gs, int seat) {
+  for (int i = 0; i < gs->player_count; i++) {
+    int next = (seat + i) % gs->player_count;
+    if (gs->players[next].is_active)
+      return next;
+  }
+  return -1;
+}
+
+void reset_game(GameState *gs) {
+  memset((void *)gs->board, ' ', sizeof(gs->board));
+  gs->turn_count = 0;
+  gs->winner_id = 0;
+  gs->current_player_index = 0;
+  gs->result_saved = 0;
+  gs->game_over = 0;
+  for (int i = 0; i < MAX_PLAYERS; i++)
+    gs->seat_input[i].premove_count = 0; // Planned for the old board
+}
@@ -0,0 +1,402 @@
+#define _XOPEN_SOURCE 700
+#include "../include/common.h"
+#include <poll.h>
+#include <unistd.h>
+
+// Routes players across backend servers (./server N --tcp PORT), which may
+// run on any host. A JOIN is answered with REDIRECT to the backend whose
+// match is closest to full, so matches fill one at a time and the gateway
+// stays off the data path. SCORES lists each backend's win counts; TOP and
+// RANK go to a backend, as all of them share one ratings journal.
+
+#define MAX_BACKENDS 32
+#define BACKEND_TIMEOUT_MS 500 // To connect to a backend, then per reply line
+
+typedef struct {
+  char host[64];
+  char port[8];
+  int pending;          // REDIRECTed players not seated yet
+  time_t pending_since; // Last REDIRECT; stale after HELLO_TIMEOUT_SEC
+  int last_present;     // Seated players at the previous STATUS
+} Backend;
+
+typedef struct {
+  int needed;
+  int present;
+  int free_seats;
+  int wins[MAX_PLAYERS];
+} BackendStatus;
+
+// Clients that have not sent their opening line yet. The loop reads them
+// without blocking, and each must finish within HELLO_TIMEOUT_SEC of its
+// accept, so a slow or silent client never holds up the others.
+typedef struct {
+  int fd;
+  int state; // 0: still reading, 1: line complete, -1: drop it
+  long long deadline_ms;
+  int len;
+  char line[64];
+} Greeting;
+
+Backend backends[MAX_BACKENDS];
+int backend_count = 0;
+int gateway_socket = -1;
+const char *bind_address = "127.0.0.1"; // --bind
+Greeting greetings[HELLO_PENDING_MAX];
+int greeting_count = 0;
+
+long long now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// Reads one '\n'-terminated line, giving up timeout_ms after the call
+// however the bytes trickle in
+int read_line(int sock, char *line, size_t len, int timeout_ms) {
+  long long deadline = now_ms() + timeout_ms;
+
+  size_t n = 0;
+  char c = '\0';
+  while (n + 1 < len) {
+    long long left_ms = deadline - now_ms();
+    struct pollfd pfd = {.fd = sock, .events = POLLIN};
+    if (left_ms <= 0 || poll(&pfd, 1, left_ms) <= 0 ||
+        recv(sock, &c, 1, 0) != 1 || c == '\n')
+      break;
+    line[n++] = c;
+  }
+  line[n] = '\0';
+  return c == '\n' ? (int)n : -1;
+}
+
+// Connects without blocking, so an unreachable backend costs at most
+// BACKEND_TIMEOUT_MS for all of its addresses together
+int connect_backend(const Backend *b) {
+  struct addrinfo hints, *res, *ai;
+  int sock = -1;
+  long long deadline = now_ms() + BACKEND_TIMEOUT_MS;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(b->host, b->port, &hints, &res) != 0)
+    return -1;
+
+  for (ai = res; ai; ai = ai->ai_next) {
+    sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (sock < 0)
+      continue;
+    int flags = fcntl(sock, F_GETFL);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    int ok = connect(sock, ai->ai_addr, ai->ai_addrlen) == 0;
+    if (!ok && errno == EINPROGRESS) {
+      struct pollfd pfd = {.fd = sock, .events = POLLOUT};
+      long long left_ms = deadline - now_ms();
+      int err = 0;
+      socklen_t err_len = sizeof(err);
+      ok = left_ms > 0 && poll(&pfd, 1, left_ms) == 1 &&
+           getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &err_len) == 0 &&
+           err == 0;
+    }
+    if (ok) {
+      fcntl(sock, F_SETFL, flags); // Replies are read with a deadline
+      break;
+    }
+    close(sock);
+    sock = -1;
+  }
+  freeaddrinfo(res);
+  return sock;
+}
+
+// Asks a backend for "STATUS <needed> <present> <free seats> <wins...>"
+int query_status(const Backend *b, BackendStatus *st) {
+  int sock = connect_backend(b);
+  if (sock < 0)
+    return -1;
+
+  char line[128];
+  send(sock, "STATUS\n", 7, 0);
+  int n = read_line(sock, line, sizeof(line), BACKEND_TIMEOUT_MS);
+  close(sock);
+  if (n < 0)
+    return -1;
+
+  memset(st, 0, sizeof(*st));
+  int off = 0;
+  if (sscanf(line, "STATUS %d %d %d%n", &st->needed, &st->present,
+             &st->free_seats, &off) != 3 ||
+      st->needed > MAX_PLAYERS)
+    return -1;
+  for (int i = 0; i < st->needed; i++) {
+    int used = 0;
+    if (sscanf(line + off, "%d%n", &st->wins[i], &used) != 1)
+      break;
+    off += used;
+  }
+  return 0;
+}
+
+// Seats REDIRECTed players have probably not taken yet: each newly seated
+// player settles one, and after HELLO_TIMEOUT_SEC the rest have given up.
+int pending_redirects(Backend *b, const BackendStatus *st, time_t now) {
+  if (st->present > b->last_present)
+    b->pending -= st->present - b->last_present;
+  b->last_present = st->present;
+  if (b->pending < 0 || now - b->pending_since > HELLO_TIMEOUT_SEC)
+    b->pending = 0;
+  return b->pending;
+}
+
+void route_join(int client) {
+  time_t now = time(NULL);
+  int best = -1, best_present = -1;
+
+  for (int i = 0; i < backend_count; i++) {
+    BackendStatus st;
+    if (query_status(&backends[i], &st) == -1)
+      continue;
+    int pending = pending_redirects(&backends[i], &st, now);
+    if (st.free_seats - pending <= 0)
+      continue;
+    // Fill the fullest open match first so games start as soon as possible
+    if (st.present + pending > best_present) {
+      best = i;
+      best_present = st.present + pending;
+    }
+  }
+
+  char reply[128];
+  if (best == -1) {
+    snprintf(reply, sizeof(reply), "FULL\n");
+    printf("[Gateway] No open seat on any backend.\n");
+  } else {
+    Backend *b = &backends[best];
+    b->pending++;
+    b->pending_since = now;
+    snprintf(reply, sizeof(reply), "REDIRECT %s %s\n", b->host, b->port);
+    printf("[Gateway] Player sent to %s:%s\n", b->host, b->port);
+  }
+  send(client, reply, strlen(reply), 0);
+}
+
+// Win counts by seat, one line per reachable backend: each backend hosts
+// its own match, so its seats are not the same players as another's
+void report_scores(int client) {
+  char reply[128 + MAX_BACKENDS * 96];
+  int reachable = 0, off = 0;
+  BackendStatus st[MAX_BACKENDS];
+  int up[MAX_BACKENDS];
+
+  for (int i = 0; i < backend_count; i++) {
+    up[i] = query_status(&backends[i], &st[i]) == 0;
+    reachable += up[i];
+  }
+
+  off += snprintf(reply + off, sizeof(reply) - off, "SCORES %d/%d backends\n",
+                  reachable, backend_count);
+  for (int i = 0; i < backend_count; i++) {
+    if (!up[i])
+      continue;
+    off += snprintf(reply + off, sizeof(reply) - off, "%s:%s",
+                    backends[i].host, backends[i].port);
+    for (int p = 0; p < st[i].needed; p++)
+      off += snprintf(reply + off, sizeof(reply) - off, " %c %d",
+                      PLAYER_SYMBOLS[p], st[i].wins[p]);
+    off += snprintf(reply + off, sizeof(reply) - off, "\n");
+  }
+  snprintf(reply + off, sizeof(reply) - off, "END\n");
+  send(client, reply, strlen(reply), 0);
+}
+
+// Relays a TOP or RANK query to the first backend that answers it. The
+// backends share one ratings journal, so any of them has every rating.
+void forward_query(int client, const char *query) {
+  char line[128];
+  for (int i = 0; i < backend_count; i++) {
+    int sock = connect_backend(&backends[i]);
+    if (sock < 0)
+      continue;
+    snprintf(line, sizeof(line), "%s\n", query);
+    send(sock, line, strlen(line), 0);
+    int replied = 0, n;
+    // The backend closes the connection after its answer
+    while ((n = read_line(sock, line, sizeof(line) - 1,
+                          BACKEND_TIMEOUT_MS)) >= 0) {
+      line[n++] = '\n';
+      send(client, line, n, 0);
+      replied = 1;
+    }
+    close(sock);
+    if (replied)
+      return;
+  }
+  send(client, "UNAVAILABLE\n", 12, 0);
+}
+
+void handle_signal(int sig) {
+  (void)sig; // unused
+  if (gateway_socket != -1)
+    close(gateway_socket);
+  _exit(0);
+}
+
+void greet(int sock) {
+  if (greeting_count == HELLO_PENDING_MAX) {
+    close(sock); // Too many at once; the client can retry
+    return;
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+  Greeting *g = &greetings[greeting_count++];
+  memset(g, 0, sizeof(*g));
+  g->fd = sock;
+  g->deadline_ms = now_ms() + HELLO_TIMEOUT_SEC * 1000LL;
+}
+
+// Takes in what has arrived of the line; the client waits for our answer,
+// so nothing follows it
+void read_greeting(Greeting *g) {
+  int room = sizeof(g->line) - 1 - g->len;
+  ssize_t n = recv(g->fd, g->line + g->len, room, 0);
+  if (n <= 0) {
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+      g->state = -1;
+    return;
+  }
+  g->len += n;
+  g->line[g->len] = '\0';
+  char *nl = strchr(g->line, '\n');
+  if (nl) {
+    *nl = '\0';
+    g->state = 1;
+  } else if (g->len == sizeof(g->line) - 1) {
+    g->state = -1; // Not a request of ours
+  }
+}
+
+void serve(int client, const char *hello) {
+  if (strncmp(hello, "JOIN", 4) == 0) {
+    route_join(client);
+  } else if (strcmp(hello, "SCORES") == 0) {
+    report_scores(client);
+  } else if (strncmp(hello, "TOP ", 4) == 0 ||
+             strncmp(hello, "RANK ", 5) == 0) {
+    forward_query(client, hello);
+  } else {
+    // Sessions live on the backend: resume there (the client knows it)
+    send(client, "REJECTED\n", 9, 0);
+  }
+}
+
+void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [--port P] [--bind addr] host:port [host:port ...]\n",
+          prog);
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  int port = GATEWAY_PORT;
+
+  signal(SIGINT, handle_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  // ./gateway [--port P] [--bind addr] host:port [host:port ...]
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      port = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+      bind_address = argv[++i];
+      continue;
+    }
+    char *colon = strrchr(argv[i], ':');
+    if (!colon || backend_count == MAX_BACKENDS)
+      usage(argv[0]);
+    Backend *b = &backends[backend_count++];
+    memset(b, 0, sizeof(*b));
+    snprintf(b->host, sizeof(b->host), "%.*s", (int)(colon - argv[i]),
+             argv[i]);
+    snprintf(b->port, sizeof(b->port), "%s", colon + 1);
+  }
+  if (backend_count == 0)
+    usage(argv[0]);
+
+  struct sockaddr_in address;
+  gateway_socket = socket(AF_INET, SOCK_STREAM, 0);
+  if (gateway_socket == -1)
+    ERR_EXIT("socket");
+
+  int one = 1;
+  setsockopt(gateway_socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  if (inet_pton(AF_INET, bind_address, &address.sin_addr) != 1) {
+    fprintf(stderr, "[Gateway] Bad --bind address %s\n", bind_address);
+    exit(1);
+  }
+
+  if (bind(gateway_socket, (struct sockaddr *)&address, sizeof(address)) < 0)
+    ERR_EXIT("bind");
+  if (listen(gateway_socket, 64) < 0)
+    ERR_EXIT("listen");
+
+  printf("[Gateway] Listening on %s:%d for %d backends.\n", bind_address,
+         port, backend_count);
+
+  // Waits on new connections and on every client still sending its line;
+  // only complete requests are served
+  while (1) {
+    struct pollfd pfds[1 + HELLO_PENDING_MAX] = {
+        {.fd = gateway_socket, .events = POLLIN}};
+    long long now = now_ms();
+    int timeout = -1;
+    for (int i = 0; i < greeting_count; i++) {
+      pfds[1 + i].fd = greetings[i].fd;
+      pfds[1 + i].events = POLLIN;
+      long long left = greetings[i].deadline_ms - now;
+      if (timeout < 0 || left < timeout)
+        timeout = left > 0 ? left : 0;
+    }
+    int ready = poll(pfds, 1 + greeting_count, timeout);
+    if (ready == -1) {
+      if (errno == EINTR)
+        continue;
+      ERR_EXIT("poll");
+    }
+
+    now = now_ms();
+    for (int i = 0; i < greeting_count; i++) {
+      if (pfds[1 + i].revents)
+        read_greeting(&greetings[i]);
+      if (greetings[i].state == 0 && now >= greetings[i].deadline_ms)
+        greetings[i].state = -1;
+    }
+    for (int i = 0; i < greeting_count;) {
+      if (greetings[i].state == 0) {
+        i++;
+        continue;
+      }
+      Greeting g = greetings[i];
+      greetings[i] = greetings[--greeting_count];
+      if (g.state == 1) {
+        fcntl(g.fd, F_SETFL, fcntl(g.fd, F_GETFL) & ~O_NONBLOCK);
+        serve(g.fd, g.line);
+      }
+      close(g.fd);
+    }
+
+    if (pfds[0].revents & POLLIN) {
+      int client = accept(gateway_socket, NULL, NULL);
+      if (client >= 0)
+        greet(client);
+      else if (errno != EINTR && errno != ECONNABORTED)
+        ERR_EXIT("accept");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include "../include/handoff.h"
+#include <unistd.h>
+
+static void upgrade_address(struct sockaddr_un *addr, const char *path) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  strncpy(addr->sun_path, path, sizeof(addr->sun_path) - 1);
+}
+
+// Control socket on which a running server waits for its replacement
+int handoff_listen(const char *path) {
+  struct sockaddr_un addr;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1)
+    return -1;
+
+  upgrade_address(&addr, path);
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(fd, 1) < 0) {
+    close(fd);
+    return -1;
+  }
+  chmod(path, 0600);
+  return fd;
+}
+
+// Asks the running server to hand over. Returns the connection to read the
+// handoff from, or -1 if no server is listening.
+int handoff_connect(const char *path) {
+  struct sockaddr_un addr;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1)
+    return -1;
+
+  upgrade_address(&addr, path);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  const char *req = "UPGRADE\n";
+  if (send(fd, req, strlen(req), 0) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int handoff_send(int conn, const HandoffInfo *info, int listen_fd,
+                 const int *client_fds) {
+  int fds[MAX_PLAYERS + 1];
+  int nfds = 1 + info->seat_count;
+  fds[0] = listen_fd;
+  memcpy(fds + 1, client_fds, info->seat_count * sizeof(int));
+
+  char control[CMSG_SPACE(sizeof(fds))];
+  memset(control, 0, sizeof(control));
+
+  struct iovec iov = {.iov_base = (void *)info, .iov_len = sizeof(*info)};
+  struct msghdr msg = {0};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+  memcpy(CMSG_DATA(cmsg), fds, nfds * sizeof(int));
+
+  return sendmsg(conn, &msg, 0) == sizeof(*info) ? 0 : -1;
+}
+
+int handoff_recv(int conn, HandoffInfo *info, int *listen_fd, int *client_fds) {
+  char control[CMSG_SPACE((MAX_PLAYERS + 1) * sizeof(int))];
+  struct iovec iov = {.iov_base = info, .iov_len = sizeof(*info)};
+  struct msghdr msg = {0};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  if (recvmsg(conn, &msg, MSG_WAITALL) != sizeof(*info))
+    return -1;
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+    return -1;
+
+  int nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+  if (info->seat_count < 0 || info->seat_count > MAX_PLAYERS ||
+      nfds != 1 + info->seat_count)
+    return -1;
+  for (int i = 0; i < info->seat_count; i++) {
+    if (info->seat_of[i] < 0 || info->seat_of[i] >= info->player_count)
+      return -1;
+  }
+
+  int fds[MAX_PLAYERS + 1];
+  memcpy(fds, CMSG_DATA(cmsg), nfds * sizeof(int));
+  *listen_fd = fds[0];
+  memcpy(client_fds, fds + 1, info->seat_count * sizeof(int));
+  info->state_path[sizeof(info->state_path) - 1] = '\0';
+  return 0;
+}
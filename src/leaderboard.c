@@ -0,0 +1,366 @@
+#include "../include/leaderboard.h"
+#include "../include/bots.h"
+#include <math.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Tree walks only touch RankNode (24 bytes); names are read on rating ties
+// and lookups, so they live in a parallel array.
+typedef struct {
+  double rating;
+  unsigned int priority; // Heap order of the treap
+  int left, right;       // Node indices, -1 for none
+  int size;              // Nodes in this subtree
+} RankNode;
+
+typedef struct {
+  char name[NAME_LEN];
+  int games;
+} RankPlayer;
+
+// Nodes are never removed (a player keeps their rating), so the pools and
+// the hash only grow.
+static RankNode *nodes = NULL;
+static RankPlayer *players = NULL;
+static int node_count = 0, node_cap = 0;
+static int root = -1;
+
+static int *slots = NULL; // Open addressing: node index or -1
+static int slot_cap = 0;
+
+// Several servers may share one journal: each appends under an exclusive
+// flock and, before using its ratings, replays what the others appended
+// since journal_offset.
+static FILE *journal = NULL; // "a+": reads anywhere, writes at the end
+static char journal_path[256];
+static long journal_offset = 0; // Replayed up to here
+static unsigned int prio_state = 0x9E3779B9;
+
+static unsigned int hash_name(const char *name) {
+  unsigned int h = 2166136261u; // FNV-1a
+  for (; *name; name++)
+    h = (h ^ (unsigned char)*name) * 16777619u;
+  return h;
+}
+
+static int size_of(int t) { return t == -1 ? 0 : nodes[t].size; }
+
+static void update(int t) {
+  nodes[t].size = 1 + size_of(nodes[t].left) + size_of(nodes[t].right);
+}
+
+// Leaderboard order: higher rating first, then by name
+static int before(int a, int b) {
+  if (nodes[a].rating != nodes[b].rating)
+    return nodes[a].rating > nodes[b].rating;
+  return strcmp(players[a].name, players[b].name) < 0;
+}
+
+// Splits t into the nodes ordered before x and the rest
+static void split(int t, int x, int *l, int *r) {
+  if (t == -1) {
+    *l = *r = -1;
+  } else if (before(t, x)) {
+    split(nodes[t].right, x, &nodes[t].right, r);
+    *l = t;
+    update(t);
+  } else {
+    split(nodes[t].left, x, l, &nodes[t].left);
+    *r = t;
+    update(t);
+  }
+}
+
+static int merge(int l, int r) {
+  if (l == -1)
+    return r;
+  if (r == -1)
+    return l;
+  if (nodes[l].priority > nodes[r].priority) {
+    nodes[l].right = merge(nodes[l].right, r);
+    update(l);
+    return l;
+  }
+  nodes[r].left = merge(l, nodes[r].left);
+  update(r);
+  return r;
+}
+
+static void insert(int x) {
+  int l, r;
+  nodes[x].left = nodes[x].right = -1;
+  nodes[x].size = 1;
+  split(root, x, &l, &r);
+  root = merge(merge(l, x), r);
+}
+
+// x must still have the rating it was inserted with
+static int erase(int t, int x) {
+  if (t == x)
+    return merge(nodes[t].left, nodes[t].right);
+  if (before(x, t))
+    nodes[t].left = erase(nodes[t].left, x);
+  else
+    nodes[t].right = erase(nodes[t].right, x);
+  update(t);
+  return t;
+}
+
+static int *find_slot(const char *name) {
+  unsigned int mask = slot_cap - 1;
+  for (unsigned int i = hash_name(name) & mask;; i = (i + 1) & mask) {
+    if (slots[i] == -1 || strcmp(players[slots[i]].name, name) == 0)
+      return &slots[i];
+  }
+}
+
+static void grow_slots(void) {
+  int old_cap = slot_cap;
+  int *old = slots;
+
+  slot_cap = slot_cap ? slot_cap * 2 : 1024;
+  slots = malloc(sizeof(int) * slot_cap);
+  if (!slots)
+    ERR_EXIT("malloc leaderboard");
+  memset(slots, -1, sizeof(int) * slot_cap);
+  for (int i = 0; i < old_cap; i++) {
+    if (old[i] != -1)
+      *find_slot(players[old[i]].name) = old[i];
+  }
+  free(old);
+}
+
+static int find(const char *name) {
+  return slot_cap ? *find_slot(name) : -1;
+}
+
+static int add_player(const char *name, double rating, int games) {
+  if ((node_count + 1) * 10 >= slot_cap * 7)
+    grow_slots();
+  if (node_count == node_cap) {
+    node_cap = node_cap ? node_cap * 2 : 1024;
+    nodes = realloc(nodes, sizeof(RankNode) * node_cap);
+    players = realloc(players, sizeof(RankPlayer) * node_cap);
+    if (!nodes || !players)
+      ERR_EXIT("realloc leaderboard");
+  }
+
+  int x = node_count++;
+  memset(&nodes[x], 0, sizeof(RankNode));
+  memset(&players[x], 0, sizeof(RankPlayer));
+  strncpy(players[x].name, name, NAME_LEN - 1);
+  nodes[x].rating = rating;
+  nodes[x].priority = xorshift32(&prio_state);
+  players[x].games = games;
+  *find_slot(players[x].name) = x;
+  insert(x);
+  return x;
+}
+
+void leaderboard_set(const char *name, double rating, int games) {
+  int x = find(name);
+  if (x == -1) {
+    add_player(name, rating, games);
+    return;
+  }
+  root = erase(root, x);
+  nodes[x].rating = rating;
+  players[x].games = games;
+  insert(x);
+}
+
+static void fill_entry(int x, RatingEntry *out) {
+  memcpy(out->name, players[x].name, NAME_LEN);
+  out->rating = nodes[x].rating;
+  out->games = players[x].games;
+}
+
+// Applies the journal lines from journal_offset on, "<name> <rating>
+// <games>", later lines superseding earlier ones. Returns the line count.
+static int replay_journal(void) {
+  char line[128], name[NAME_LEN];
+  double rating;
+  int games, lines = 0;
+
+  fseek(journal, journal_offset, SEEK_SET);
+  while (fgets(line, sizeof(line), journal)) {
+    if (sscanf(line, "%31s %lf %d", name, &rating, &games) == 3) {
+      leaderboard_set(name, rating, games);
+      lines++;
+    }
+  }
+  clearerr(journal);
+  journal_offset = ftell(journal);
+  return lines;
+}
+
+// Takes the journal lock (LOCK_SH or LOCK_EX) and catches up with the
+// other servers. A journal another server compacted meanwhile is a new file
+// under the same path: it is reopened and replayed from the start.
+static int lock_journal(int op) {
+  struct stat ours, current;
+  if (!journal)
+    return -1;
+  while (1) {
+    flock(fileno(journal), op);
+    if (stat(journal_path, &current) == -1 ||
+        fstat(fileno(journal), &ours) == -1 ||
+        (current.st_ino == ours.st_ino && current.st_dev == ours.st_dev))
+      break;
+    FILE *fp = fopen(journal_path, "a+");
+    if (!fp)
+      break; // Keep the old file; our appends stay readable there
+    fclose(journal); // Drops the lock
+    journal = fp;
+    journal_offset = 0;
+  }
+  return replay_journal();
+}
+
+static void unlock_journal(void) {
+  if (journal)
+    flock(fileno(journal), LOCK_UN);
+}
+
+// Rewrites the journal with one line per player. Called with the journal
+// locked; the others reopen the new file on their next lock_journal().
+static void compact_journal(void) {
+  char tmp_path[272];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", journal_path);
+  FILE *fp = fopen(tmp_path, "w");
+  if (!fp)
+    return;
+  for (int i = 0; i < node_count; i++)
+    fprintf(fp, "%s %.2f %d\n", players[i].name, nodes[i].rating,
+            players[i].games);
+  long written = ftell(fp);
+  if (fclose(fp) != 0 || rename(tmp_path, journal_path) != 0)
+    return;
+
+  fp = fopen(journal_path, "a+");
+  if (!fp)
+    return;
+  fclose(journal);
+  journal = fp;
+  flock(fileno(journal), LOCK_EX);
+  // Someone may have appended between the rename and this lock
+  journal_offset = written;
+  replay_journal();
+}
+
+int leaderboard_open(const char *path) {
+  if (!path)
+    return 0;
+
+  snprintf(journal_path, sizeof(journal_path), "%s", path);
+  journal = fopen(journal_path, "a+");
+  if (!journal)
+    return -1;
+  journal_offset = 0;
+  int lines = lock_journal(LOCK_EX);
+  if (lines > node_count)
+    compact_journal();
+  unlock_journal();
+  printf("[Server] Ratings loaded from %s (%d players)\n", path, node_count);
+  return node_count;
+}
+
+void leaderboard_close(void) {
+  if (journal)
+    fclose(journal);
+  journal = NULL;
+  free(nodes);
+  free(players);
+  free(slots);
+  nodes = NULL;
+  players = NULL;
+  slots = NULL;
+  node_count = node_cap = slot_cap = 0;
+  root = -1;
+}
+
+void leaderboard_record_match(char names[][NAME_LEN], int n, int winner) {
+  int ids[MAX_PLAYERS];
+  double delta[MAX_PLAYERS] = {0};
+  if (n < 2 || n > MAX_PLAYERS)
+    return;
+
+  // From the latest ratings, whichever server wrote them
+  lock_journal(LOCK_EX);
+  for (int i = 0; i < n; i++) {
+    ids[i] = find(names[i]);
+    if (ids[i] == -1)
+      ids[i] = add_player(names[i], RATING_START, 0);
+  }
+
+  // Each player plays a virtual game against every other one
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      if (i == j)
+        continue;
+      double expected =
+          1.0 / (1.0 + pow(10.0, (nodes[ids[j]].rating -
+                                  nodes[ids[i]].rating) / 400.0));
+      double actual = i == winner ? 1.0 : j == winner ? 0.0 : 0.5;
+      delta[i] += RATING_K / (n - 1) * (actual - expected);
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    int x = ids[i];
+    leaderboard_set(players[x].name, nodes[x].rating + delta[i],
+                    players[x].games + 1);
+    if (journal)
+      fprintf(journal, "%s %.2f %d\n", players[x].name, nodes[x].rating,
+              players[x].games);
+  }
+  if (journal) {
+    fflush(journal);
+    journal_offset = ftell(journal);
+  }
+  unlock_journal();
+}
+
+int leaderboard_rank(const char *name, RatingEntry *out) {
+  lock_journal(LOCK_SH);
+  unlock_journal();
+  int x = find(name);
+  if (x == -1)
+    return 0;
+
+  int rank = 0;
+  for (int t = root; t != -1;) {
+    if (t == x) {
+      fill_entry(x, out);
+      return rank + size_of(nodes[t].left) + 1;
+    }
+    if (before(x, t)) {
+      t = nodes[t].left;
+    } else {
+      rank += size_of(nodes[t].left) + 1;
+      t = nodes[t].right;
+    }
+  }
+  return 0; // Not reached: every named player is in the tree
+}
+
+// In-order walk that stops once k entries are out
+static void collect(int t, int k, RatingEntry *out, int *count) {
+  if (t == -1 || *count >= k)
+    return;
+  collect(nodes[t].left, k, out, count);
+  if (*count < k)
+    fill_entry(t, &out[(*count)++]);
+  collect(nodes[t].right, k, out, count);
+}
+
+int leaderboard_top(int k, RatingEntry *out) {
+  int count = 0;
+  lock_journal(LOCK_SH);
+  unlock_journal();
+  collect(root, k, out, &count);
+  return count;
+}
+
+int leaderboard_size(void) { return node_count; }
@@ -0,0 +1,179 @@
+#include "../include/logger.h"
+#include "../include/uring_io.h"
+#include <stdarg.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#define LOG_RING_BUFFERS 8
+
+int log_pipe[2] = {-1, -1}; // [0] Read (Logger), [1] Write (Others)
+static FILE *log_file = NULL;
+static const char *log_path = LOG_FILE;
+static int log_backend = IO_BLOCKING;
+
+void logger_init(const char *path, int io_backend) {
+  log_path = path;
+  log_backend = io_backend;
+  if (pipe(log_pipe) == -1) {
+    ERR_EXIT("pipe");
+  }
+}
+
+int logger_backend(void) { return log_backend; }
+
+void logger_close(void) {
+  close(log_pipe[0]);
+  close(log_pipe[1]);
+}
+
+// Helper to send logs to the logger thread (dropped without one, as in
+// --sim)
+void log_msg(const char *format, ...) {
+  char buffer[256];
+  if (log_pipe[1] == -1)
+    return;
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+
+  // Write to pipe (Atomic for < PIPE_BUF)
+  // We append a newline if missing, but vsnprintf doesn't do that auto.
+  // The logger expects lines? Or just raw bytes.
+  // Let's ensure it ends with newline or handle it in logger.
+  // Ideally, we write one atomic chunk.
+  // Ideally, we write one atomic chunk.
+  if (write(log_pipe[1], buffer, strlen(buffer)) == -1) {
+    perror("log_msg write failed");
+  }
+}
+
+static void reap_log_writes(UringIO *ring, int *busy, int *in_flight) {
+  unsigned long long buf_index;
+  int res;
+  while (uring_reap(ring, &buf_index, &res)) {
+    if (res < 0)
+      fprintf(stderr, "[Logger] write failed: %s\n", strerror(-res));
+    busy[buf_index] = 0;
+    (*in_flight)--;
+  }
+}
+
+// io_uring variant: the pipe is drained into registered buffers and each
+// chunk is written with WRITE_FIXED, a burst from many handlers going out
+// as one submission. The file is opened O_APPEND and written at offset -1,
+// so every chunk lands at the end even with a second writer, such as the
+// old server's logger during a --takeover. The writes of a submission are
+// linked, and a submission goes out only once the previous one completed,
+// so the chunks reach the file in the order they left the pipe. Returns -1
+// if io_uring is unavailable.
+static int logger_loop_uring(void) {
+  static char bufs[LOG_RING_BUFFERS][LOG_BUFFER_SIZE];
+  struct iovec iovs[LOG_RING_BUFFERS];
+  int busy[LOG_RING_BUFFERS] = {0};
+  UringIO ring;
+
+  if (uring_init(&ring, LOG_RING_BUFFERS) == -1)
+    return -1;
+  for (int i = 0; i < LOG_RING_BUFFERS; i++) {
+    iovs[i].iov_base = bufs[i];
+    iovs[i].iov_len = LOG_BUFFER_SIZE;
+  }
+  if (uring_register_buffers(&ring, iovs, LOG_RING_BUFFERS) == -1) {
+    uring_exit(&ring);
+    return -1;
+  }
+
+  int fd = open(log_path, O_WRONLY | O_CREAT | O_APPEND, 0666);
+  if (fd == -1) {
+    perror("Failed to open log file");
+    uring_exit(&ring);
+    pthread_exit(NULL);
+  }
+  printf("[Logger] Thread started (io_uring). Writing to %s\n", log_path);
+
+  int next = 0, in_flight = 0, chain = 0;
+  while (1) {
+    // Reuse a buffer only once its write has completed
+    while (busy[next]) {
+      uring_wait(&ring, 1);
+      reap_log_writes(&ring, busy, &in_flight);
+    }
+
+    ssize_t n = read(log_pipe[0], bufs[next], LOG_BUFFER_SIZE);
+    if (n <= 0)
+      break;
+    // Keep filling buffers while more lines are already waiting
+    int waiting = 0;
+    int more = !busy[(next + 1) % LOG_RING_BUFFERS] &&
+               ioctl(log_pipe[0], FIONREAD, &waiting) == 0 && waiting > 0;
+    uring_prep_write_fixed(&ring, fd, bufs[next], n, -1, next, more, next);
+    busy[next] = 1;
+    chain++;
+    next = (next + 1) % LOG_RING_BUFFERS;
+    if (more)
+      continue;
+
+    while (in_flight > 0) {
+      uring_wait(&ring, 1);
+      reap_log_writes(&ring, busy, &in_flight);
+    }
+    uring_submit(&ring, 0);
+    in_flight += chain;
+    chain = 0;
+    reap_log_writes(&ring, busy, &in_flight);
+  }
+
+  if (chain > 0) {
+    uring_submit(&ring, 0);
+    in_flight += chain;
+  }
+  while (in_flight > 0) {
+    uring_wait(&ring, 1);
+    reap_log_writes(&ring, busy, &in_flight);
+  }
+  close(fd);
+  uring_exit(&ring);
+  return 0;
+}
+
+// Logger Thread Function
+void *logger_thread(void *arg) {
+  (void)arg;
+
+  // Close the write end in the logger thread (it only reads)
+  // close(log_pipe[1]); // Caution: threads share FDs. If we close it here,
+  // it might close for main too if not careful. But this is a thread.
+  // Actually, for threads, FDs are shared. We shouldn't close the write end
+  // if other threads (like main or scheduler) need to write to it.
+
+  if (log_backend == IO_URING) {
+    if (logger_loop_uring() == 0)
+      return NULL;
+    printf("[Logger] io_uring unavailable. Using blocking writes.\n");
+    log_backend = IO_BLOCKING;
+  }
+
+  log_file = fopen(log_path, "a");
+  if (!log_file) {
+    perror("Failed to open log file");
+    pthread_exit(NULL);
+  }
+  printf("[Logger] Thread started. Writing to %s\n", log_path);
+
+  char buffer[LOG_BUFFER_SIZE];
+  ssize_t n;
+  while ((n = read(log_pipe[0], buffer, sizeof(buffer) - 1)) > 0) {
+    buffer[n] = '\0';
+    if (log_file) {
+      fprintf(log_file, "%s", buffer);
+      fflush(log_file); // Ensure it's written immediately
+    }
+
+    // Also print to stdout for debugging visibility
+    // printf("%s", buffer);
+  }
+
+  fclose(log_file);
+  return NULL;
+}
@@ -0,0 +1,191 @@
+#include "../include/match_slab.h"
+#include "../include/game_logic.h"
+#include <unistd.h>
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+
+static size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+// The whole generation goes into the id, which stays positive
+static long long make_id(int slot, unsigned int generation) {
+  return (long long)generation << SLAB_SLOT_BITS | slot;
+}
+
+// Tries a hugetlb reservation first, then transparent huge pages, then
+// plain pages. Hugetlb pools are usually empty unless an admin sized them.
+static void *map_slab(size_t *bytes, int flags, int *backing) {
+  void *base;
+
+  *backing = SLAB_PAGES_NORMAL;
+  if (flags & SLAB_HUGE_PAGES) {
+#ifdef MAP_HUGETLB
+    size_t huge_bytes = round_up(*bytes, HUGE_PAGE_SIZE);
+    base = mmap(NULL, huge_bytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED) {
+      *bytes = huge_bytes;
+      *backing = SLAB_PAGES_HUGETLB;
+      return base;
+    }
+#endif
+    *bytes = round_up(*bytes, HUGE_PAGE_SIZE);
+  }
+
+  base = mmap(NULL, *bytes, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+#ifdef MADV_HUGEPAGE
+  if ((flags & SLAB_HUGE_PAGES) && madvise(base, *bytes, MADV_HUGEPAGE) == 0)
+    *backing = SLAB_PAGES_THP;
+#endif
+  return base;
+}
+
+int match_slab_init(MatchSlab *slab, int capacity, int flags) {
+  memset(slab, 0, sizeof(*slab));
+  if (capacity <= 0 || capacity > SLAB_MAX_CAPACITY)
+    return -1;
+
+  // hot | boards | cold, each array starting on a cache line
+  size_t hot_bytes = sizeof(MatchHot) * capacity;
+  size_t board_bytes =
+      round_up(sizeof(slab->boards[0]) * capacity, CACHE_LINE);
+  size_t cold_bytes = sizeof(MatchCold) * capacity;
+  size_t bytes = round_up(hot_bytes + board_bytes + cold_bytes,
+                          sysconf(_SC_PAGESIZE));
+
+  char *base = map_slab(&bytes, flags, &slab->backing);
+  if (!base)
+    return -1;
+
+  slab->base = base;
+  slab->bytes = bytes;
+  slab->hot = (MatchHot *)base;
+  slab->boards = (char(*)[BOARD_SIZE][BOARD_SIZE])(base + hot_bytes);
+  slab->cold = (MatchCold *)(base + hot_bytes + board_bytes);
+  slab->capacity = capacity;
+
+  // Fresh anonymous pages are zero; only the free list links need writing.
+  // Board and cold pages of slots never handed out stay unbacked.
+  for (int i = 0; i < capacity; i++)
+    slab->hot[i].next_free = i + 1 < capacity ? i + 1 : -1;
+  slab->free_head = 0;
+  return 0;
+}
+
+void match_slab_destroy(MatchSlab *slab) {
+  if (slab->base)
+    munmap(slab->base, slab->bytes);
+  memset(slab, 0, sizeof(*slab));
+}
+
+int match_slab_slot(const MatchSlab *slab, long long id) {
+  if (id < 0)
+    return -1;
+  int slot = id & (SLAB_MAX_CAPACITY - 1);
+  if (slot >= slab->capacity || !slab->hot[slot].in_use ||
+      id != make_id(slot, slab->hot[slot].generation))
+    return -1;
+  return slot;
+}
+
+long long match_slab_alloc(MatchSlab *slab, int player_count) {
+  if (slab->free_head == -1 || player_count < 1 || player_count > MAX_PLAYERS)
+    return -1;
+
+  int slot = slab->free_head;
+  MatchHot *hot = &slab->hot[slot];
+  MatchCold *cold = &slab->cold[slot];
+
+  slab->free_head = hot->next_free;
+  slab->in_use++;
+  hot->next_free = -1;
+  hot->generation++;
+  hot->in_use = 1;
+  hot->player_count = player_count;
+  hot->active_mask = (1u << player_count) - 1;
+
+  for (int i = 0; i < player_count; i++) {
+    cold->seats[i].id = i + 1;
+    cold->seats[i].symbol = PLAYER_SYMBOLS[i];
+    cold->seats[i].greedy_top = 0;
+    cold->win_counts[i] = 0;
+  }
+  long long id = make_id(slot, hot->generation);
+  match_slab_reset(slab, id);
+  return id;
+}
+
+void match_slab_free(MatchSlab *slab, long long id) {
+  int slot = match_slab_slot(slab, id);
+  if (slot == -1)
+    return;
+  MatchHot *hot = &slab->hot[slot];
+  hot->in_use = 0;
+  hot->active_mask = 0;
+  hot->next_free = slab->free_head;
+  slab->free_head = slot;
+  slab->in_use--;
+}
+
+int match_slab_reset(MatchSlab *slab, long long id) {
+  int slot = match_slab_slot(slab, id);
+  if (slot == -1)
+    return -1;
+  MatchHot *hot = &slab->hot[slot];
+  memset(slab->boards[slot], ' ', sizeof(slab->boards[slot]));
+  hot->turn_count = 0;
+  hot->current_player_index = 0;
+  hot->game_over = 0;
+  hot->winner_id = 0;
+  return 0;
+}
+
+int match_slab_move(MatchSlab *slab, long long id, int seat, int row, int col) {
+  int slot = match_slab_slot(slab, id);
+  if (slot == -1 || seat < 0 || seat >= slab->hot[slot].player_count)
+    return MOVE_INVALID;
+  MatchHot *hot = &slab->hot[slot];
+  char(*board)[BOARD_SIZE] = slab->boards[slot];
+  char symbol = PLAYER_SYMBOLS[seat];
+  if (hot->game_over || !board_is_valid_move(board, row, col))
+    return MOVE_INVALID;
+
+  board[row][col] = symbol;
+  hot->turn_count++;
+  if (board_check_win(board, row, col, symbol)) {
+    hot->game_over = 1;
+    hot->winner_id = seat + 1;
+    slab->cold[slot].win_counts[seat]++;
+    return MOVE_WIN;
+  }
+  if (hot->turn_count >= BOARD_SIZE * BOARD_SIZE) {
+    hot->game_over = 1;
+    hot->winner_id = 0; // Draw
+    return MOVE_DRAW;
+  }
+  return MOVE_PLACED;
+}
+
+int match_slab_next_seat(const MatchSlab *slab, long long id, int seat) {
+  int slot = match_slab_slot(slab, id);
+  if (slot == -1)
+    return -1;
+  const MatchHot *hot = &slab->hot[slot];
+  for (int i = 0; i < hot->player_count; i++) {
+    int next = (seat + i) % hot->player_count;
+    if (hot->active_mask & (1u << next))
+      return next;
+  }
+  return -1;
+}
+
+int match_slab_set_bot(MatchSlab *slab, long long id, int seat,
+                       int greedy_top) {
+  int slot = match_slab_slot(slab, id);
+  if (slot == -1 || seat < 0 || seat >= slab->hot[slot].player_count)
+    return -1;
+  slab->cold[slot].seats[seat].greedy_top = greedy_top;
+  return 0;
+}
@@ -0,0 +1,238 @@
+#define _GNU_SOURCE // sched_setaffinity, CPU_SET
+#include "../include/placement.h"
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+
+#define MPOL_PREFERRED 1
+#define MPOL_MF_MOVE (1 << 1)
+#define MAX_NODES 64
+
+static int enabled = 0;
+static cpu_set_t game_set, io_set;
+static int game_node = -1;
+
+typedef struct {
+  unsigned long long busy, total;
+} CpuTimes;
+
+static CpuTimes start_times[PLACEMENT_MAX_CPUS], last_times[PLACEMENT_MAX_CPUS];
+static int have_start = 0;
+
+static int node_of(int cpu) {
+  char path[96];
+  for (int node = 0; node < MAX_NODES; node++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu,
+             node);
+    if (access(path, F_OK) == 0)
+      return node;
+  }
+  return -1; // No NUMA information: treat as one node
+}
+
+// "0-3,6" -> set; CPUs must be ones we may run on
+static int parse_list(const char *list, const cpu_set_t *allowed,
+                      cpu_set_t *set) {
+  CPU_ZERO(set);
+  for (const char *p = list; *p;) {
+    char *end;
+    long first = strtol(p, &end, 10), last = first;
+    if (end == p)
+      return -1;
+    if (*end == '-') {
+      p = end + 1;
+      last = strtol(p, &end, 10);
+      if (end == p)
+        return -1;
+    }
+    if (first < 0 || last < first || last >= PLACEMENT_MAX_CPUS)
+      return -1;
+    for (long c = first; c <= last; c++) {
+      if (!CPU_ISSET(c, allowed))
+        return -1;
+      CPU_SET(c, set);
+    }
+    p = *end == ',' ? end + 1 : end;
+    if (*end && *end != ',')
+      return -1;
+  }
+  return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+static void format_set(const cpu_set_t *set, char *out, size_t len) {
+  int off = 0;
+  out[0] = '\0';
+  for (int c = 0; c < PLACEMENT_MAX_CPUS; c++) {
+    if (!CPU_ISSET(c, set))
+      continue;
+    int last = c;
+    while (last + 1 < PLACEMENT_MAX_CPUS && CPU_ISSET(last + 1, set))
+      last++;
+    off += snprintf(out + off, len - off, off ? ",%d" : "%d", c);
+    if (last > c)
+      off += snprintf(out + off, len - off, "-%d", last);
+    if (off >= (int)len)
+      return;
+    c = last;
+  }
+}
+
+// Cumulative busy and total jiffies per CPU
+static int read_times(CpuTimes *times) {
+  FILE *fp = fopen("/proc/stat", "r");
+  if (!fp)
+    return -1;
+  memset(times, 0, sizeof(CpuTimes) * PLACEMENT_MAX_CPUS);
+  char line[256];
+  while (fgets(line, sizeof(line), fp)) {
+    unsigned long long v[8] = {0};
+    int cpu;
+    // cpuN user nice system idle iowait irq softirq steal
+    if (sscanf(line, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu", &cpu,
+               &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) < 5 ||
+        cpu < 0 || cpu >= PLACEMENT_MAX_CPUS)
+      continue;
+    for (int i = 0; i < 8; i++)
+      times[cpu].total += v[i];
+    times[cpu].busy = times[cpu].total - v[3] - v[4];
+  }
+  fclose(fp);
+  return 0;
+}
+
+int placement_configure(const char *game_list, const char *io_list) {
+  cpu_set_t allowed;
+  char game_text[128], io_text[128];
+
+  if (!have_start && read_times(start_times) == 0) {
+    memcpy(last_times, start_times, sizeof(last_times));
+    have_start = 1;
+  }
+  if (!game_list)
+    return 0;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1)
+    return -1;
+
+  if (strcmp(game_list, "auto") == 0) {
+    // The node of the first allowed CPU; its last CPU does the I/O
+    int first = -1, io_cpu = -1;
+    CPU_ZERO(&game_set);
+    for (int c = 0; c < PLACEMENT_MAX_CPUS; c++) {
+      if (!CPU_ISSET(c, &allowed))
+        continue;
+      if (first == -1)
+        first = c;
+      if (node_of(c) == node_of(first)) {
+        CPU_SET(c, &game_set);
+        io_cpu = c;
+      }
+    }
+    if (first == -1)
+      return -1;
+    if (!io_list && CPU_COUNT(&game_set) > 1)
+      CPU_CLR(io_cpu, &game_set);
+    CPU_ZERO(&io_set);
+    CPU_SET(io_cpu, &io_set);
+  } else if (parse_list(game_list, &allowed, &game_set) == -1) {
+    return -1;
+  } else {
+    // I/O gets what the game cores leave, or shares them if nothing does
+    CPU_XOR(&io_set, &allowed, &game_set);
+    if (CPU_COUNT(&io_set) == 0)
+      io_set = game_set;
+  }
+  if (io_list && parse_list(io_list, &allowed, &io_set) == -1)
+    return -1;
+
+  for (int c = 0; c < PLACEMENT_MAX_CPUS; c++) {
+    if (CPU_ISSET(c, &game_set)) {
+      game_node = node_of(c);
+      break;
+    }
+  }
+  enabled = 1;
+
+  format_set(&game_set, game_text, sizeof(game_text));
+  format_set(&io_set, io_text, sizeof(io_text));
+  printf("[Server] Game cores: %s (node %d), I/O cores: %s\n", game_text,
+         game_node, io_text);
+  cpu_set_t shared;
+  CPU_AND(&shared, &game_set, &io_set);
+  if (CPU_COUNT(&shared) > 0)
+    printf("[Server] Warning: I/O shares game cores (%d CPUs allowed)\n",
+           CPU_COUNT(&allowed));
+  return 0;
+}
+
+int placement_enabled(void) { return enabled; }
+
+void placement_pin_game(void) {
+  if (enabled && sched_setaffinity(0, sizeof(game_set), &game_set) == -1)
+    perror("[Server] sched_setaffinity game");
+}
+
+void placement_pin_io(void) {
+  if (enabled && sched_setaffinity(0, sizeof(io_set), &io_set) == -1)
+    perror("[Server] sched_setaffinity io");
+}
+
+void placement_bind_memory(void *addr, size_t len) {
+  if (!enabled || game_node < 0)
+    return;
+  // Raw mbind (no libnuma). Fails harmlessly on kernels without NUMA.
+  unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+  mask[game_node / (8 * sizeof(unsigned long))] |=
+      1UL << (game_node % (8 * sizeof(unsigned long)));
+  long page = sysconf(_SC_PAGESIZE);
+  unsigned long start = (unsigned long)addr & ~(page - 1);
+  syscall(SYS_mbind, start, (unsigned long)addr + len - start, MPOL_PREFERRED,
+          mask, MAX_NODES + 1, MPOL_MF_MOVE);
+}
+
+int placement_usage(CpuUsage *out, int max, int since_start) {
+  CpuTimes now[PLACEMENT_MAX_CPUS];
+  if (!have_start || read_times(now) == -1)
+    return 0;
+
+  const CpuTimes *base = since_start ? start_times : last_times;
+  int n = 0;
+  for (int c = 0; c < PLACEMENT_MAX_CPUS && n < max; c++) {
+    if (now[c].total == 0)
+      continue; // Offline or absent
+    unsigned long long total = now[c].total - base[c].total;
+    int game = enabled && CPU_ISSET(c, &game_set);
+    int io = enabled && CPU_ISSET(c, &io_set);
+    out[n].cpu = c;
+    out[n].busy =
+        total ? 100.0 * (now[c].busy - base[c].busy) / total : 0.0;
+    out[n].role = game && io ? "game+io" : game ? "game" : io ? "io" : "-";
+    n++;
+  }
+  if (!since_start)
+    memcpy(last_times, now, sizeof(last_times));
+  return n;
+}
+
+#else // Not Linux: no affinity API, nothing is pinned
+
+int placement_configure(const char *game_list, const char *io_list) {
+  (void)io_list;
+  return game_list ? -1 : 0;
+}
+int placement_enabled(void) { return 0; }
+void placement_pin_game(void) {}
+void placement_pin_io(void) {}
+void placement_bind_memory(void *addr, size_t len) {
+  (void)addr;
+  (void)len;
+}
+int placement_usage(CpuUsage *out, int max, int since_start) {
+  (void)out;
+  (void)max;
+  (void)since_start;
+  return 0;
+}
+
+#endif
@@ -1,25 +1,99 @@
 #define _XOPEN_SOURCE 700
 #include "../include/common.h"
+#include "../include/evaluator.h"
 #include "../include/game_logic.h"
-#include <stdarg.h>
+#include "../include/handoff.h"
+#include "../include/leaderboard.h"
+#include "../include/logger.h"
+#include "../include/placement.h"
+#include "../include/state_store.h"
+#include "../include/sim.h"
+#include "../include/tournament.h"
+#include "../include/turns.h"
+#include "../include/uring_io.h"
+#include "../include/vclock.h"
+#include <ctype.h>
+#include <poll.h>
 #include <time.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+// Transport (--tcp). A TCP server on port P appends "_P" to its IPC names
+// and files so several backends can share one host.
+int tcp_port = 0; // 0: Unix domain socket at SOCKET_PATH
+const char *bind_address = "127.0.0.1"; // --bind, for --tcp
+char shm_name[64];
+char scheduler_sem_name[64];
+char upgrade_path[108];
+char admin_path[108];
+char score_path[64];
+const char *ratings_path = RATINGS_FILE; // --ratings, shared by backends
+char log_path[64];
 
 // Globals for cleanup signal handler
-int shm_fd = -1;
+const char *state_path = NULL; // --state-file, NULL for the shm segment
 GameState *game_state = NULL;
+Turns turns; // The match's turn flow, on game_state (see turns.h)
 // sem_t *mutex = NULL; // REMOVED
-sem_t *turn_sems[MAX_PLAYERS];
-sem_t *sem_scheduler = NULL; // New Scheduler Semaphore
 int server_socket = -1;
-int log_pipe[2]; // [0] Read (Logger), [1] Write (Others)
-FILE *log_file = NULL;
-pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+int io_backend = IO_BLOCKING; // --io uring for the io_uring paths
+const char *game_cpus = NULL;  // --cpus, NULL: let the kernel place us
+const char *io_cpus = NULL;    // --io-cpus
 volatile sig_atomic_t server_running = 1;
 
+// Hot upgrade (--takeover) state, parent side
+int client_socks[MAX_PLAYERS] = {-1, -1, -1, -1, -1}; // Kept for the handoff
+pid_t child_pids[MAX_PLAYERS];
+int upgrade_socket = -1;
+int admin_socket = -1; // Leaderboard queries
+int handed_off = 0;
+pthread_t scheduler_tid;
+
+// Set in a handler process when the server is handing off to a new one
+volatile sig_atomic_t handler_stop = 0;
+
+// Handler process's own ring (--io uring); rings are not shared across fork
+UringIO handler_ring = {.fd = -1};
+
+// Connections that have not sent their opening line yet ("JOIN",
+// "RESUME <token>", "STATUS" or an admin query). The poll loops read them
+// without blocking, and each must finish within HELLO_TIMEOUT_SEC of its
+// accept, so a slow or silent client never holds up the match.
+typedef struct {
+  int fd;
+  int admin; // Came in on the admin socket
+  int state; // 0: still reading, 1: line complete, -1: drop it
+  long long deadline_us;
+  int len;
+  char line[64];
+} Greeting;
+
+Greeting greetings[HELLO_PENDING_MAX];
+int greeting_count = 0;
+
+// "score.txt" -> "score_7001.txt" when serving TCP port 7001
+void instance_name(char *buf, size_t len, const char *name) {
+  const char *dot = strrchr(name, '.');
+  if (!tcp_port) {
+    snprintf(buf, len, "%s", name);
+    return;
+  }
+  if (!dot || strchr(dot, '/'))
+    dot = name + strlen(name);
+  snprintf(buf, len, "%.*s_%d%s", (int)(dot - name), name, tcp_port, dot);
+}
+
+void turn_sem_name(char *buf, size_t len, int seat) {
+  char base[64];
+  snprintf(base, sizeof(base), "%s%d", SEM_TURN_NAME_PREFIX, seat);
+  instance_name(buf, len, base);
+}
+
 // Helper to load scores from file
 void load_scores(GameState *gs) {
-  FILE *fp = fopen("score.txt", "r");
+  FILE *fp = fopen(score_path, "r");
   if (!fp)
     return; // No scores yet
 
@@ -34,118 +108,7 @@ void load_scores(GameState *gs) {
     }
   }
   fclose(fp);
-  printf("[Server] Scores loaded from score.txt\n");
-}
-
-// Helper to send logs to the logger thread
-void log_msg(const char *format, ...) {
-  char buffer[256];
-  va_list args;
-  va_start(args, format);
-  vsnprintf(buffer, sizeof(buffer), format, args);
-  va_end(args);
-
-  // Write to pipe (Atomic for < PIPE_BUF)
-  // We append a newline if missing, but vsnprintf doesn't do that auto.
-  // The logger expects lines? Or just raw bytes.
-  // Let's ensure it ends with newline or handle it in logger.
-  // Ideally, we write one atomic chunk.
-  // Ideally, we write one atomic chunk.
-  if (write(log_pipe[1], buffer, strlen(buffer)) == -1) {
-    perror("log_msg write failed");
-  }
-}
-
-// Logger Thread Function
-void *logger_thread(void *arg) {
-  (void)arg;
-
-  // Close the write end in the logger thread (it only reads)
-  // close(log_pipe[1]); // Caution: threads share FDs. If we close it here,
-  // it might close for main too if not careful. But this is a thread.
-  // Actually, for threads, FDs are shared. We shouldn't close the write end
-  // if other threads (like main or scheduler) need to write to it.
-
-  log_file = fopen("game_log.txt", "a");
-  if (!log_file) {
-    perror("Failed to open log file");
-    pthread_exit(NULL);
-  }
-  printf("[Logger] Thread started. Writing to game_log.txt\n");
-
-  char buffer[LOG_BUFFER_SIZE];
-  ssize_t n;
-  while ((n = read(log_pipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-    buffer[n] = '\0';
-    if (log_file) {
-      fprintf(log_file, "%s", buffer);
-      fflush(log_file); // Ensure it's written immediately
-    }
-
-    // Also print to stdout for debugging visibility
-    // printf("%s", buffer);
-  }
-
-  fclose(log_file);
-  return NULL;
-}
-
-// Round Robin Scheduler Thread
-void *scheduler_thread(void *arg) {
-  (void)arg;
-  printf("[Scheduler] Thread started. Controlling turn order.\n");
-
-  while (1) {
-    // Wait for a player to finish their turn
-    // Wait for a player to finish their turn
-    if (sem_wait(sem_scheduler) == -1) {
-      if (errno != EINTR)
-        perror("sem_wait scheduler");
-      continue;
-    }
-
-    pthread_mutex_lock(&game_state->game_mutex);
-    if (game_state->game_over) {
-      pthread_mutex_unlock(&game_state->game_mutex);
-      pthread_mutex_unlock(
-          &game_state->game_mutex); // Unlock logic for wait (double post in old
-                                    // code?)
-      // Actually old code had double sem_post? Line 79 was sem_post(mutex).
-      // Ah, wait logic below needs careful lock management.
-
-      printf("[Scheduler] Game Over detected. Waiting for reset...\n");
-      // Wait for Main to reset game_over flag
-      while (1) {
-        usleep(POLL_INTERVAL_US / 2); // 100ms
-        pthread_mutex_lock(&game_state->game_mutex);
-        if (!game_state->game_over) {
-          pthread_mutex_unlock(&game_state->game_mutex);
-          printf("[Scheduler] Reset detected. Resuming for new game.\n");
-          break;
-        }
-        pthread_mutex_unlock(&game_state->game_mutex);
-      }
-      // Continue loop for next game
-      continue;
-    }
-
-    // Determine next player (Round Robin)
-    int current_id = game_state->current_player_index; // 0-based index
-    int next_id = (current_id + 1) % game_state->player_count;
-
-    // Update state
-    game_state->current_player_index = next_id;
-    pthread_mutex_unlock(&game_state->game_mutex);
-
-    printf("[Scheduler] Signaling Player %d (Index %d) to go next.\n",
-           next_id + 1, next_id);
-    log_msg("[Scheduler] Player %d (%d) -> Player %d (%d)\n", current_id + 1,
-            current_id, next_id + 1, next_id);
-    if (sem_post(turn_sems[next_id]) == -1) {
-      perror("sem_post turn_sems");
-    }
-  }
-  return NULL;
+  printf("[Server] Scores loaded from %s\n", score_path);
 }
 
 // Cleanup function
@@ -153,30 +116,50 @@ void cleanup() {
   printf("\n[Server] Cleaning up resources...\n");
 
   // Close log pipe
-  close(log_pipe[0]);
-  close(log_pipe[1]);
+  logger_close();
+
+  for (int i = 0; i < MAX_PLAYERS; i++) {
+    if (client_socks[i] != -1)
+      close(client_socks[i]);
+  }
+  if (upgrade_socket != -1)
+    close(upgrade_socket);
+  if (admin_socket != -1)
+    close(admin_socket);
+  leaderboard_close();
+
+  if (handed_off) {
+    // The new server owns the socket path, state and semaphores now
+    state_store_detach(game_state);
+    game_state = NULL;
+    if (server_socket != -1)
+      close(server_socket);
+    return;
+  }
 
   // Unlink socket
-  unlink(SOCKET_PATH);
-  if (game_state)
-    munmap(game_state, sizeof(GameState));
-  if (shm_fd != -1)
-    close(shm_fd);
-  shm_unlink(SHM_NAME);
+  if (!tcp_port)
+    unlink(SOCKET_PATH);
+  if (upgrade_socket != -1)
+    unlink(upgrade_path);
+  if (admin_socket != -1)
+    unlink(admin_path);
 
   if (game_state) {
     pthread_mutex_destroy(&game_state->game_mutex);
   }
+  state_store_close(game_state, state_path);
+  game_state = NULL;
   // if (mutex) { sem_close(mutex); sem_unlink(SEM_MUTEX_NAME); }
 
-  if (sem_scheduler) {
-    sem_close(sem_scheduler);
-    sem_unlink(SEM_SCHEDULER_NAME);
+  if (turns.sem_scheduler) {
+    sem_close(turns.sem_scheduler);
+    sem_unlink(scheduler_sem_name);
   }
 
   for (int i = 0; i < MAX_PLAYERS; i++) {
     char sem_name[64];
-    snprintf(sem_name, sizeof(sem_name), "%s%d", SEM_TURN_NAME_PREFIX, i);
+    turn_sem_name(sem_name, sizeof(sem_name), i);
     sem_unlink(sem_name);
   }
 
@@ -201,11 +184,176 @@ void handle_sigchld(int sig) {
     ;
 }
 
+void handle_stop(int sig) {
+  (void)sig; // unused
+  handler_stop = 1;
+}
+
+// Handler exit during a handoff: the client socket stays open in the old
+// server until it has been passed on, so the client never notices.
+void stop_if_handed_off(int client_sock) {
+  if (handler_stop) {
+    close(client_sock);
+    exit(0);
+  }
+}
+
+// Non-blocking check for a hang-up while the player is not being prompted
+int client_gone(int client_sock) {
+  char c;
+  ssize_t n = recv(client_sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                    errno != EINTR);
+}
+
+// Leaves the seat for the player to RESUME (see vacate_seat) and ends the
+// handler. In the lobby the parent frees it instead (release_vacated_seats).
+void leave_seat(int player_id, int client_sock, int holding_turn) {
+  vacate_seat(&turns, player_id, holding_turn);
+  log_msg("[Connection] Player %d disconnected.\n", player_id + 1);
+  close(client_sock);
+  exit(0);
+}
+
+// "HINT [n]" during a turn: the n best moves for this seat as
+// "HINTS r c score ...", best first. The board is copied so the mutex is
+// not held while the evaluator runs.
+void send_hints(int player_id, int client_sock, const char *request) {
+  char board[BOARD_SIZE][BOARD_SIZE];
+  MoveHint hints[HINT_MAX];
+  char reply[BUFFER_SIZE];
+  int n = 3;
+
+  sscanf(request, "HINT %d", &n);
+  if (n < 1)
+    n = 1;
+  if (n > HINT_MAX)
+    n = HINT_MAX;
+
+  pthread_mutex_lock(&game_state->game_mutex);
+  memcpy(board, (const void *)game_state->board, sizeof(board));
+  int players = game_state->player_count;
+  pthread_mutex_unlock(&game_state->game_mutex);
+
+  int count = suggest_moves((const char(*)[BOARD_SIZE])board, players,
+                            player_id, hints, n);
+  int len = snprintf(reply, sizeof(reply), "HINTS");
+  for (int i = 0; i < count; i++)
+    len += snprintf(reply + len, sizeof(reply) - len, " %d %d %d",
+                    hints[i].row, hints[i].col, hints[i].score);
+  snprintf(reply + len, sizeof(reply) - len, "\n");
+  send(client_sock, reply, strlen(reply), 0);
+}
+
+// Reads what the client sent into the seat's input (waiting for it with
+// wait). Returns recv's result: 0 on hang-up, -1 with errno EAGAIN when
+// nothing is there.
+int read_input(SeatInput *in, int client_sock, int wait) {
+  int room = sizeof(in->input) - 1 - in->input_len;
+  if (room == 0)
+    return 1; // A full buffer is handed out as one line
+  int bytes = recv(client_sock, in->input + in->input_len, room,
+                   wait ? 0 : MSG_DONTWAIT);
+  if (bytes > 0) {
+    in->input_len += bytes;
+    in->input[in->input_len] = '\0';
+  }
+  return bytes;
+}
+
+// Length of the input line starting at start, or -1 while it is incomplete
+int input_line(SeatInput *in, int start) {
+  if (start >= in->input_len)
+    return -1;
+  char *nl = memchr(in->input + start, '\n', in->input_len - start);
+  if (nl)
+    return nl - (in->input + start);
+  if (start == 0 && in->input_len == (int)sizeof(in->input) - 1)
+    return in->input_len;
+  return -1;
+}
+
+// Drops the input line starting at start (with its newline)
+void input_cut(SeatInput *in, int start, int len) {
+  int end = start + len < in->input_len ? start + len + 1 : start + len;
+  memmove(in->input + start, in->input + end, in->input_len - end);
+  in->input_len -= end - start;
+  in->input[in->input_len] = '\0';
+}
+
+void input_consume(SeatInput *in, int len) { input_cut(in, 0, len); }
+
+// "PRE r c" queues a move, "PRE CLEAR" drops the queue; both are answered
+// with "PREMOVES <queued>". Cells are only checked when the turn comes.
+void premove_command(SeatInput *in, int client_sock, const char *line) {
+  char reply[32];
+  int row, col;
+  if (strncmp(line, "PRE CLEAR", 9) == 0) {
+    in->premove_count = 0;
+  } else if (sscanf(line, "PRE %d %d", &row, &col) == 2 &&
+             in->premove_count < PREMOVE_MAX) {
+    in->premoves[in->premove_count][0] = row;
+    in->premoves[in->premove_count][1] = col;
+    in->premove_count++;
+  }
+  snprintf(reply, sizeof(reply), "PREMOVES %d\n", in->premove_count);
+  send(client_sock, reply, strlen(reply), 0);
+}
+
+// Takes in every premove sent while waiting; moves and anything else stay
+// buffered, in order, for the turn
+void read_premoves(int player_id, int client_sock, int holding_turn) {
+  SeatInput *in = &game_state->seat_input[player_id];
+  if (read_input(in, client_sock, 0) == 0)
+    leave_seat(player_id, client_sock, holding_turn);
+  int start = 0, len;
+  while ((len = input_line(in, start)) >= 0) {
+    if (strncmp(in->input + start, "PRE", 3) == 0) {
+      premove_command(in, client_sock, in->input + start);
+      input_cut(in, start, len);
+    } else {
+      start += len + 1;
+    }
+  }
+}
+
+// Plays the first queued premove ("PREMOVED r c"). If its cell was taken
+// the rest of the plan is void too: the queue is dropped with
+// "PREMOVE_FAILED r c" and 0 is returned so the player is prompted.
+int play_premove(int player_id, int client_sock) {
+  SeatInput *in = &game_state->seat_input[player_id];
+  char reply[48];
+  int row = in->premoves[0][0], col = in->premoves[0][1];
+  in->premove_count--;
+  memmove(in->premoves, in->premoves[1],
+          sizeof(in->premoves[0]) * in->premove_count);
+
+  int placed = play_move(&turns, player_id, row, col) != MOVE_INVALID;
+  if (!placed)
+    in->premove_count = 0;
+  snprintf(reply, sizeof(reply), "%s %d %d\n",
+           placed ? "PREMOVED" : "PREMOVE_FAILED", row, col);
+  send(client_sock, reply, strlen(reply), 0);
+  return placed;
+}
+
 void handle_client(int player_id, int client_sock) {
   // Child process logic
   GameState *gs = game_state; // Shared memory mapping is inherited
 
+  if (io_backend == IO_URING && uring_init(&handler_ring, 4) == -1)
+    handler_ring.fd = -1; // Stay on blocking sends
+
+  // SIGTERM only raises a flag (no SA_RESTART) so a handoff never cuts a move
+  // or a message in half; blocking calls return EINTR and we exit cleanly.
+  struct sigaction stop;
+  stop.sa_handler = &handle_stop;
+  sigemptyset(&stop.sa_mask);
+  stop.sa_flags = 0;
+  sigaction(SIGTERM, &stop, NULL);
+
   Player *me = &gs->players[player_id];
+  SeatInput *in = &gs->seat_input[player_id];
   printf("[Player %d] Handler started. Symbol: %c\n", me->id, me->symbol);
 
   char buffer[BUFFER_SIZE];
@@ -215,8 +363,13 @@ void handle_client(int player_id, int client_sock) {
   while (1) {
     // --- POLLING LOOP FOR TURN OR UPDATES ---
     while (1) {
+      stop_if_handed_off(client_sock);
+      if (client_gone(client_sock))
+        leave_seat(player_id, client_sock, 0);
+      read_premoves(player_id, client_sock, 0);
+
       // Try to acquire Turn Semaphore
-      int ret = sem_trywait(turn_sems[player_id]);
+      int ret = sem_trywait(turns.turn_sems[player_id]);
       if (ret == 0) {
         // Got the semaphore! It is my turn.
         // Check game_over status immediately for debugging
@@ -268,9 +421,9 @@ void handle_client(int player_id, int client_sock) {
         }
       }
 
-      // Sleep a bit to avoid CPU spin
-      // Sleep a bit to avoid CPU spin
-      usleep(POLL_INTERVAL_US);
+      // Sleep until the turn comes, checking the board again meanwhile
+      if (wait_for_turn(&turns, player_id, POLL_INTERVAL_US) == 0)
+        break; // My turn
     }
 
     // --- MY TURN or GAME OVER ---
@@ -298,14 +451,12 @@ void handle_client(int player_id, int client_sock) {
       }
       off += sprintf(final_board + off, "END\n");
 
-      printf("[DEBUG] Player %d sending Final Board...\n", me->id);
-      send(client_sock, final_board, strlen(final_board), 0);
-      printf("[DEBUG] Player %d sent Final Board.\n", me->id);
-
-      // Send Game Over
+      // Send Final Board and Game Over
       snprintf(buffer, sizeof(buffer), "GAME_OVER %d\n", winner);
-      printf("[DEBUG] Player %d sending GAME_OVER...\n", me->id);
-      send(client_sock, buffer, strlen(buffer), 0);
+      printf("[DEBUG] Player %d sending Final Board and GAME_OVER...\n",
+             me->id);
+      send_pair(&handler_ring, client_sock, final_board, strlen(final_board),
+                buffer, strlen(buffer));
       printf("[DEBUG] Player %d sent GAME_OVER.\n", me->id);
 
       // Propagate signal -> To SCHEDULER (which will stop) or next player?
@@ -320,7 +471,8 @@ void handle_client(int player_id, int client_sock) {
       // Wait for Game Reset
       printf("[Player %d] Waiting for new game...\n", me->id);
       while (1) {
-        sleep(1);
+        vclock_sleep(1);
+        stop_if_handed_off(client_sock);
         pthread_mutex_lock(&gs->game_mutex);
         if (!gs->game_over) {
           pthread_mutex_unlock(&gs->game_mutex);
@@ -333,6 +485,11 @@ void handle_client(int player_id, int client_sock) {
       continue;             // Restart the outer 'while(1)' loop
     }
 
+    // A queued premove plays right away, without a prompt
+    read_premoves(player_id, client_sock, 1);
+    if (in->premove_count > 0 && play_premove(player_id, client_sock))
+      continue;
+
     // Send Board State (My Turn View)
     char board_str[2048];
     int offset = 0;
@@ -352,64 +509,53 @@ void handle_client(int player_id, int client_sock) {
       offset += sprintf(board_str + offset, "\n");
     }
     offset += sprintf(board_str + offset, "END\n");
-    send(client_sock, board_str, strlen(board_str), 0);
 
-    // Send YOUR_TURN Command to prompt input
+    // Send YOUR_TURN Command to prompt input (together with the board)
     char *turn_cmd = "YOUR_TURN\n";
-    send(client_sock, turn_cmd, strlen(turn_cmd), 0);
+    send_pair(&handler_ring, client_sock, board_str, strlen(board_str),
+              turn_cmd, strlen(turn_cmd));
 
     // Update tracking
     last_turn_count = gs->turn_count;
 
-    // Receive Move
-    memset(buffer, 0, BUFFER_SIZE);
-    int bytes = recv(client_sock, buffer, BUFFER_SIZE, 0);
-    if (bytes <= 0) {
-      log_msg("[Connection] Player %d disconnected.\n", me->id);
-      break; // Client disconnected
-    }
-
-    int row, col;
-    if (sscanf(buffer, "%d %d", &row, &col) == 2) {
-      pthread_mutex_lock(&gs->game_mutex);
-      if (is_valid_move(gs, row, col)) {
-        gs->board[row][col] = me->symbol;
-        gs->turn_count++;
-        // removed last_turn_count update so I get the spectator update showing
-        // my own move
-        // printf("[DEBUG] Player %d placed at %d, %d\n", me->id, row, col);
-        log_msg("[Gameplay] Player %d placed '%c' at (%d, %d)\n", me->id,
-                me->symbol, row, col);
-
-        if (check_win(gs, row, col, me->symbol)) {
-          gs->game_over = 1;
-          gs->winner_id = me->id;
-          printf("[Server] Player %d WINS!\n", me->id);
-        } else if (is_board_full(gs)) {
-          gs->game_over = 1;
-          gs->winner_id = 0; // Draw
-          printf("[Server] Draw!\n");
+    // Receive Move. Hints and premoves are answered without giving up the
+    // turn; a premove that comes in now is this turn's move.
+    int len, row, col;
+    while (1) {
+      while ((len = input_line(in, 0)) < 0) {
+        int bytes = read_input(in, client_sock, 1);
+        if (bytes < 0 && errno == EINTR)
+          stop_if_handed_off(client_sock); // Turn is re-offered by the new server
+        if (bytes <= 0) {
+          leave_seat(player_id, client_sock, 1); // Client disconnected
         }
+      }
+      if (strncmp(in->input, "HINT", 4) == 0)
+        send_hints(player_id, client_sock, in->input);
+      else if (strncmp(in->input, "PRE", 3) == 0)
+        premove_command(in, client_sock, in->input);
+      else
+        break;
+      input_consume(in, len);
+      if (in->premove_count > 0)
+        break;
+    }
 
-        // Next player logic handled by Scheduler
-        // gs->current_player_index = (gs->current_player_index + 1) %
-        // gs->player_count; // REMOVED: Scheduler does this
-
-        // printf("[DEBUG] Player %d finished. Signaling Scheduler.\n", me->id);
-        // printf("[DEBUG] Player %d finished. Signaling Scheduler.\n", me->id);
-        if (sem_post(sem_scheduler) == -1)
-          perror("sem_post scheduler"); // Signal Scheduler
-
-      } else {
+    if (in->premove_count > 0) {
+      if (!play_premove(player_id, client_sock))
+        vclock_sem_post(turns.turn_sems[player_id]); // Prompt again
+    } else if (sscanf(in->input, "%d %d", &row, &col) == 2) {
+      input_consume(in, len);
+      if (play_move(&turns, player_id, row, col) == MOVE_INVALID) {
         // Invalid move, signal SAME player to try again
         char *msg = "INVALID\n";
         send(client_sock, msg, strlen(msg), 0);
         printf("[DEBUG] Player %d Invalid Move. Posting self.\n", me->id);
-        sem_post(turn_sems[player_id]); // Signal myself again
+        vclock_sem_post(turns.turn_sems[player_id]); // Signal myself again
       }
-      pthread_mutex_unlock(&gs->game_mutex);
     } else {
-      sem_post(turn_sems[player_id]); // Try again
+      input_consume(in, len);
+      vclock_sem_post(turns.turn_sems[player_id]); // Try again
     }
   }
 
@@ -417,8 +563,591 @@ void handle_client(int player_id, int client_sock) {
   exit(0);
 }
 
+// Forks the handler process for a seat. The parent keeps its copy of the
+// client socket so it can be passed on in a hot upgrade.
+void spawn_handler(int seat, int client_sock) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Child
+#ifdef __linux__
+    // Die with the server so a restarted one never races stale handlers
+    // over the state file.
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    placement_pin_game(); // The parent runs on the I/O cores
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+      if (i != seat && client_socks[i] != -1)
+        close(client_socks[i]);
+    }
+    if (upgrade_socket != -1)
+      close(upgrade_socket);
+    for (int i = 0; i < greeting_count; i++)
+      close(greetings[i].fd); // Still being read by the parent
+    handle_client(seat, client_sock);
+  } else if (pid < 0) {
+    ERR_EXIT("fork");
+  }
+
+  client_socks[seat] = client_sock;
+  child_pids[seat] = pid;
+}
+
+// 3. Setup Socket (TCP with --tcp)
+void listen_for_players_tcp() {
+  struct sockaddr_in address;
+  server_socket = socket(AF_INET, SOCK_STREAM, 0);
+  if (server_socket == -1)
+    ERR_EXIT("socket");
+
+  int one = 1;
+  setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(tcp_port);
+  if (inet_pton(AF_INET, bind_address, &address.sin_addr) != 1) {
+    fprintf(stderr, "[Server] Bad --bind address %s\n", bind_address);
+    exit(1);
+  }
+
+  if (bind(server_socket, (struct sockaddr *)&address, sizeof(address)) < 0)
+    ERR_EXIT("bind");
+  if (listen(server_socket, 16) < 0)
+    ERR_EXIT("listen");
+
+  printf("[Server] Listening on %s:%d. Waiting for players...\n",
+         bind_address, tcp_port);
+}
+
+// 3. Setup Socket (Unix Domain)
+void listen_for_players() {
+  if (tcp_port) {
+    listen_for_players_tcp();
+    return;
+  }
+
+  struct sockaddr_un address;
+  server_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server_socket == -1) // Corrected error check for socket
+    ERR_EXIT("socket");
+
+  // Clean up old socket file if it exists
+  unlink(SOCKET_PATH);
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, SOCKET_PATH, sizeof(address.sun_path) - 1);
+
+  if (bind(server_socket, (struct sockaddr *)&address, sizeof(address)) < 0)
+    ERR_EXIT("bind");
+
+  // Set permissions so clients can access it
+  chmod(SOCKET_PATH, 0666);
+
+  if (listen(server_socket, 5) < 0)
+    ERR_EXIT("listen");
+
+  printf("[Server] Listening on %s. Waiting for players...\n", SOCKET_PATH);
+}
+
+void greet(int sock, int admin) {
+  if (greeting_count == HELLO_PENDING_MAX) {
+    close(sock); // Too many at once; the client can retry
+    return;
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+  Greeting *g = &greetings[greeting_count++];
+  memset(g, 0, sizeof(*g));
+  g->fd = sock;
+  g->admin = admin;
+  g->deadline_us = vclock_now_us() + HELLO_TIMEOUT_SEC * 1000000LL;
+}
+
+// Takes in what has arrived of the line, never past its newline: what
+// follows belongs to the seat's handler.
+void read_greeting(Greeting *g) {
+  char peek[sizeof(g->line)];
+  int room = sizeof(g->line) - 1 - g->len;
+  ssize_t n = recv(g->fd, peek, room, MSG_PEEK);
+  if (n <= 0) {
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+      g->state = -1;
+    return;
+  }
+  char *nl = memchr(peek, '\n', n);
+  int take = nl ? nl - peek + 1 : n;
+  if (recv(g->fd, g->line + g->len, take, 0) != take) {
+    g->state = -1;
+    return;
+  }
+  g->len += take;
+  g->line[g->len] = '\0';
+  if (nl) {
+    g->line[g->len - 1] = '\0';
+    g->state = 1;
+  } else if (g->len == sizeof(g->line) - 1) {
+    g->state = -1; // Not a hello of ours
+  }
+}
+
+// Adds the pending connections to a poll set after its first n entries.
+// Returns the poll timeout: max_ms (-1: none), less if a deadline comes
+// first.
+int poll_greetings(struct pollfd *pfds, int n, int max_ms) {
+  long long now = vclock_now_us();
+  int timeout = max_ms;
+  for (int i = 0; i < greeting_count; i++) {
+    pfds[n + i].fd = greetings[i].fd;
+    pfds[n + i].events = POLLIN;
+    pfds[n + i].revents = 0;
+    long long left = (greetings[i].deadline_us - now + 999) / 1000;
+    if (timeout < 0 || left < timeout)
+      timeout = left > 0 ? left : 0;
+  }
+  return timeout;
+}
+
+int seat_client(int sock, const char *hello, int players_needed,
+                int in_match);
+void handle_admin(int conn, const char *line);
+
+// Reads the pending connections poll() found ready (from pfds[n] on) and
+// serves those whose line is complete; late or broken ones are closed.
+void serve_greetings(struct pollfd *pfds, int n, int players_needed,
+                     int in_match) {
+  long long now = vclock_now_us();
+  for (int i = 0; i < greeting_count; i++) {
+    if (pfds[n + i].revents)
+      read_greeting(&greetings[i]);
+    if (greetings[i].state == 0 && now >= greetings[i].deadline_us)
+      greetings[i].state = -1;
+  }
+
+  // Each one leaves the table before it is served, so a handler forked
+  // meanwhile closes exactly the connections still pending (spawn_handler)
+  for (int i = 0; i < greeting_count;) {
+    if (greetings[i].state == 0) {
+      i++;
+      continue;
+    }
+    Greeting g = greetings[i];
+    greetings[i] = greetings[--greeting_count];
+    if (g.state == -1) {
+      close(g.fd);
+    } else if (g.admin) {
+      handle_admin(g.fd, g.line);
+      close(g.fd);
+    } else {
+      fcntl(g.fd, F_SETFL, fcntl(g.fd, F_GETFL) & ~O_NONBLOCK);
+      seat_client(g.fd, g.line, players_needed, in_match);
+    }
+  }
+}
+
+void new_token(char *token) {
+  unsigned char raw[(TOKEN_LEN - 1) / 2];
+  int fd = open("/dev/urandom", O_RDONLY);
+  if (fd == -1 || read(fd, raw, sizeof(raw)) != sizeof(raw)) {
+    srand(time(NULL) ^ getpid());
+    for (size_t i = 0; i < sizeof(raw); i++)
+      raw[i] = rand() & 0xff;
+  }
+  if (fd != -1)
+    close(fd);
+  for (size_t i = 0; i < sizeof(raw); i++)
+    sprintf(token + 2 * i, "%02x", raw[i]);
+}
+
+// A JOIN may take a seat that was never used, or abandoned past the grace
+// window. Caller holds game_mutex.
+int seat_is_free(Player *p, time_t now) {
+  return !p->is_active &&
+         (p->token[0] == '\0' || now - p->disconnected_at > SESSION_GRACE_SEC);
+}
+
+int free_seat(int players_needed, time_t now) {
+  for (int i = 0; i < players_needed; i++) {
+    if (seat_is_free(&game_state->players[i], now))
+      return i;
+  }
+  return -1;
+}
+
+// Seat held for this token, if still within its grace window
+int resume_seat(int players_needed, const char *token, time_t now) {
+  for (int i = 0; i < players_needed; i++) {
+    Player *p = &game_state->players[i];
+    if (!p->is_active && p->token[0] != '\0' &&
+        strcmp(p->token, token) == 0 &&
+        now - p->disconnected_at <= SESSION_GRACE_SEC)
+      return i;
+  }
+  return -1;
+}
+
+// Names key the leaderboard and its journal: no spaces, printable only
+int valid_name(const char *name) {
+  size_t len = strlen(name);
+  if (len == 0 || len >= NAME_LEN)
+    return 0;
+  for (size_t i = 0; i < len; i++) {
+    if (!isalnum((unsigned char)name[i]) && !strchr("_-.", name[i]))
+      return 0;
+  }
+  return 1;
+}
+
+// A name is taken while a present or held seat uses it. Caller holds
+// game_mutex.
+int name_in_use(int players_needed, const char *name, time_t now) {
+  for (int i = 0; i < players_needed; i++) {
+    Player *p = &game_state->players[i];
+    if (!seat_is_free(p, now) && strcmp(p->name, name) == 0)
+      return 1;
+  }
+  return 0;
+}
+
+// Peer address for the connection log
+void peer_name(int sock, char *buf, size_t len) {
+  struct sockaddr_in peer;
+  socklen_t peer_len = sizeof(peer);
+  if (tcp_port &&
+      getpeername(sock, (struct sockaddr *)&peer, &peer_len) == 0) {
+    snprintf(buf, len, "%s:%d", inet_ntoa(peer.sin_addr),
+             ntohs(peer.sin_port));
+  } else {
+    snprintf(buf, len, "local");
+  }
+}
+
+// Answers a STATUS query (used by ./gateway to place players and aggregate
+// scores): "STATUS <needed> <present> <free seats> <wins per seat...>"
+void send_status(int sock, int players_needed, int in_match) {
+  char reply[128];
+  time_t now = vclock_now();
+  int present = 0, free_seats = 0;
+  pthread_mutex_lock(&game_state->game_mutex);
+  for (int i = 0; i < players_needed; i++) {
+    present += game_state->players[i].is_active;
+    free_seats += !in_match && seat_is_free(&game_state->players[i], now);
+  }
+  int off = snprintf(reply, sizeof(reply), "STATUS %d %d %d", players_needed,
+                     present, free_seats);
+  for (int i = 0; i < players_needed; i++)
+    off += snprintf(reply + off, sizeof(reply) - off, " %d",
+                    game_state->win_counts[i]);
+  pthread_mutex_unlock(&game_state->game_mutex);
+  snprintf(reply + off, sizeof(reply) - off, "\n");
+  send(sock, reply, strlen(reply), 0);
+}
+
+int present_seats(int players_needed) {
+  int present = 0;
+  pthread_mutex_lock(&game_state->game_mutex);
+  for (int i = 0; i < players_needed; i++)
+    present += game_state->players[i].is_active;
+  pthread_mutex_unlock(&game_state->game_mutex);
+  return present;
+}
+
+// Seats a new connection: a JOIN gets a free seat and a fresh session token
+// (before the match starts only), a RESUME gets its old seat back and a
+// snapshot of the board. Returns the seat, or -1 if the client was turned
+// away.
+int seat_client(int sock, const char *hello, int players_needed,
+                int in_match) {
+  if (strcmp(hello, "STATUS") == 0) {
+    send_status(sock, players_needed, in_match);
+    close(sock);
+    return -1;
+  }
+  if (strncmp(hello, "TOP ", 4) == 0 || strncmp(hello, "RANK ", 5) == 0) {
+    handle_admin(sock, hello); // Leaderboard queries, e.g. via ./gateway
+    close(sock);
+    return -1;
+  }
+  if (tcp_port) {
+    // Board and YOUR_TURN go out as separate small writes
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  time_t now = vclock_now();
+  int resumed = strncmp(hello, "RESUME ", 7) == 0;
+  int seat = -1;
+  const char *msg = resumed ? "REJECTED\n" : "FULL\n";
+
+  // "JOIN <name>" plays rated under that name; a bare JOIN is unrated
+  const char *name = "";
+  if (strncmp(hello, "JOIN ", 5) == 0) {
+    name = hello + 5;
+    if (!valid_name(name)) {
+      send(sock, "BADNAME\n", 8, 0);
+      close(sock);
+      return -1;
+    }
+  }
+
+  pthread_mutex_lock(&game_state->game_mutex);
+  if (resumed) {
+    seat = resume_seat(players_needed, hello + 7, now);
+  } else if (name[0] && name_in_use(players_needed, name, now)) {
+    msg = "NAME_TAKEN\n";
+  } else if (!in_match && strncmp(hello, "JOIN", 4) == 0) {
+    seat = free_seat(players_needed, now);
+  }
+
+  if (seat == -1) {
+    pthread_mutex_unlock(&game_state->game_mutex);
+    send(sock, msg, strlen(msg), 0);
+    close(sock);
+    return -1;
+  }
+
+  Player *p = &game_state->players[seat];
+  SeatInput *in = &game_state->seat_input[seat];
+  if (!resumed) {
+    new_token(p->token);
+    strncpy(p->name, name, NAME_LEN - 1);
+    p->name[NAME_LEN - 1] = '\0';
+    in->premove_count = 0;
+  }
+  p->id = seat + 1; // 1-based ID
+  p->socket_fd = sock;
+  p->symbol = PLAYER_SYMBOLS[seat];
+  p->is_active = 1;
+  in->input_len = 0; // Left over from the dropped connection
+  in->input[0] = '\0';
+  pthread_mutex_unlock(&game_state->game_mutex);
+
+  // A resumed player's premoves are still queued; say how many
+  char reply[128];
+  int len = snprintf(reply, sizeof(reply), "SESSION %s %d\n", p->token, p->id);
+  if (resumed)
+    snprintf(reply + len, sizeof(reply) - len, "PREMOVES %d\n",
+             in->premove_count);
+  send(sock, reply, strlen(reply), 0);
+
+  char peer[64];
+  peer_name(sock, peer, sizeof(peer));
+  char who[NAME_LEN + 32];
+  if (p->name[0])
+    snprintf(who, sizeof(who), "Player %d (%s)", seat + 1, p->name);
+  else
+    snprintf(who, sizeof(who), "Player %d", seat + 1);
+  printf("[Server] %s %s!\n", who, resumed ? "reconnected" : "connected");
+  log_msg("[Connection] %s %s from %s\n", who,
+          resumed ? "resumed" : "connected", peer);
+
+  if (client_socks[seat] != -1)
+    close(client_socks[seat]); // Our copy of the dropped connection
+  spawn_handler(seat, sock);
+
+  // A match with nobody present waits for the first player back
+  if (in_match)
+    resume_turn(&turns, seat);
+  return seat;
+}
+
+// Closes our copy of connections whose handler has left the seat. Only a
+// seat in a match is held for RESUME: one left in the lobby is free for
+// the next JOIN right away.
+void release_vacated_seats(int players_needed, int in_match) {
+  pthread_mutex_lock(&game_state->game_mutex);
+  for (int i = 0; i < players_needed; i++) {
+    Player *p = &game_state->players[i];
+    if (!p->is_active && client_socks[i] != -1) {
+      close(client_socks[i]);
+      client_socks[i] = -1;
+      child_pids[i] = 0;
+      if (!in_match) {
+        p->token[0] = '\0';
+        log_msg("[Connection] Player %d left the lobby. Seat freed.\n",
+                i + 1);
+      }
+    }
+  }
+  pthread_mutex_unlock(&game_state->game_mutex);
+}
+
+// Rates a finished match. Only matches where every seat joined with a name
+// count; a bare JOIN plays unrated.
+void rate_match(char names[][NAME_LEN], int n, int winner) {
+  for (int i = 0; i < n; i++) {
+    if (!names[i][0])
+      return;
+  }
+  leaderboard_record_match(names, n, winner - 1);
+  for (int i = 0; i < n; i++) {
+    RatingEntry e;
+    int rank = leaderboard_rank(names[i], &e);
+    log_msg("[Rating] %s %.0f (rank %d of %d)\n", e.name, e.rating, rank,
+            leaderboard_size());
+  }
+}
+
+// Answers one leaderboard query on the admin socket:
+//   "TOP k"     -> "<rank> <name> <rating> <games>" lines, then "END"
+//   "RANK name" -> "RANK <rank> <name> <rating> <games>" or "UNKNOWN"
+void handle_admin(int conn, const char *line) {
+  char name[NAME_LEN], reply[128];
+  int k;
+
+  if (sscanf(line, "TOP %d", &k) == 1) {
+    if (k < 1)
+      k = 1;
+    if (k > ADMIN_TOP_MAX)
+      k = ADMIN_TOP_MAX;
+    RatingEntry top[ADMIN_TOP_MAX];
+    int n = leaderboard_top(k, top);
+    for (int i = 0; i < n; i++) {
+      snprintf(reply, sizeof(reply), "%d %s %.0f %d\n", i + 1, top[i].name,
+               top[i].rating, top[i].games);
+      send(conn, reply, strlen(reply), 0);
+    }
+    send(conn, "END\n", 4, 0);
+  } else if (sscanf(line, "RANK %31s", name) == 1) {
+    RatingEntry e;
+    int rank = leaderboard_rank(name, &e);
+    if (rank)
+      snprintf(reply, sizeof(reply), "RANK %d %s %.0f %d\n", rank, e.name,
+               e.rating, e.games);
+    else
+      snprintf(reply, sizeof(reply), "UNKNOWN\n");
+    send(conn, reply, strlen(reply), 0);
+  } else if (strncmp(line, "CPUS", 4) == 0) {
+    // Per-core busy share since the previous CPUS query
+    CpuUsage usage[PLACEMENT_MAX_CPUS];
+    int n = placement_usage(usage, PLACEMENT_MAX_CPUS, 0);
+    for (int i = 0; i < n; i++) {
+      snprintf(reply, sizeof(reply), "CPU %d %s %.1f\n", usage[i].cpu,
+               usage[i].role, usage[i].busy);
+      send(conn, reply, strlen(reply), 0);
+    }
+    send(conn, "END\n", 4, 0);
+  } else {
+    send(conn, "ERROR\n", 6, 0);
+  }
+}
+
+// 4. Accept Players
+void accept_players(int players_needed) {
+  while (present_seats(players_needed) < players_needed && server_running) {
+    // The leaderboard stays queryable while the lobby fills
+    struct pollfd pfds[2 + HELLO_PENDING_MAX] = {
+        {.fd = server_socket, .events = POLLIN},
+        {.fd = admin_socket, .events = POLLIN}};
+    int timeout = poll_greetings(pfds, 2, -1);
+    if (poll(pfds, 2 + greeting_count, timeout) == -1) {
+      if (errno == EINTR)
+        continue;
+      ERR_EXIT("poll");
+    }
+    release_vacated_seats(players_needed, 0);
+    serve_greetings(pfds, 2, players_needed, 0);
+    if (pfds[1].revents & POLLIN) {
+      int conn = accept(admin_socket, NULL, NULL);
+      if (conn != -1)
+        greet(conn, 1);
+    }
+    if (pfds[0].revents & POLLIN) {
+      int new_socket = accept(server_socket, NULL, NULL);
+      if (new_socket < 0)
+        ERR_EXIT("accept");
+      greet(new_socket, 0);
+    }
+  }
+}
+
+// Stops the scheduler and all handlers so the match is frozen between moves.
+void stop_match(int players_needed) {
+  pthread_cancel(scheduler_tid);
+  pthread_join(scheduler_tid, NULL);
+
+  for (int i = 0; i < players_needed; i++) {
+    if (child_pids[i] > 0)
+      kill(child_pids[i], SIGTERM);
+  }
+  for (int i = 0; i < players_needed; i++) {
+    // Give each handler a second to finish its move, then force it
+    for (int tries = 0; child_pids[i] > 0; tries++) {
+      pid_t r = waitpid(child_pids[i], NULL, WNOHANG);
+      if (r != 0) // Reaped here, or already by handle_sigchld
+        break;
+      if (tries == 10)
+        kill(child_pids[i], SIGKILL);
+      vclock_sleep_us(POLL_INTERVAL_US / 2);
+    }
+    child_pids[i] = 0;
+  }
+
+  // A finished turn the scheduler never consumed still moves the turn on
+  int pending = 0;
+  sem_getvalue(turns.sem_scheduler, &pending);
+  if (pending > 0 && !game_state->game_over) {
+    game_state->current_player_index =
+        (game_state->current_player_index + 1) % game_state->player_count;
+  }
+}
+
+// Serves one upgrade request: freezes the match and passes the listening
+// socket, client sockets and state location to the new server. If the new
+// server does not confirm, the match resumes here. Returns 0 once handed off.
+int hand_off(int conn, int players_needed) {
+  char req[16] = {0};
+  if (recv(conn, req, sizeof(req) - 1, 0) <= 0 ||
+      strncmp(req, "UPGRADE", 7) != 0)
+    return -1;
+
+  printf("[Server] Upgrade requested. Handing off the match...\n");
+  log_msg("[Upgrade] Handing off at turn %d\n", game_state->turn_count);
+  stop_match(players_needed);
+
+  HandoffInfo info;
+  int socks[MAX_PLAYERS];
+  memset(&info, 0, sizeof(info));
+  info.player_count = players_needed;
+  for (int i = 0; i < players_needed; i++) {
+    if (game_state->players[i].is_active && client_socks[i] != -1) {
+      info.seat_of[info.seat_count] = i;
+      socks[info.seat_count++] = client_socks[i];
+    }
+  }
+  if (state_path)
+    strncpy(info.state_path, state_path, sizeof(info.state_path) - 1);
+
+  char ack[8] = {0};
+  if (handoff_send(conn, &info, server_socket, socks) == 0 &&
+      recv(conn, ack, sizeof(ack) - 1, 0) > 0 && strncmp(ack, "OK", 2) == 0) {
+    printf("[Server] Match handed off. Exiting.\n");
+    return 0;
+  }
+
+  printf("[Server] Upgrade failed. Resuming the match.\n");
+  for (int i = 0; i < info.seat_count; i++)
+    spawn_handler(info.seat_of[i], socks[i]);
+  if (pthread_create(&scheduler_tid, NULL, scheduler_thread, &turns) != 0)
+    ERR_EXIT("pthread_create scheduler");
+  restart_turns(&turns, players_needed);
+  return -1;
+}
+
+void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [num_players 3-5] [--state-file path] [--takeover] "
+          "[--tcp port [--bind addr]] [--ratings path] [--io blocking|uring] [--cpus auto|list "
+          "[--io-cpus list]] "
+          "[--sim games [--seed n] [--greedy seats] [--matches n]] "
+          "[--tournament roster [--format roundrobin|swiss|rotate] "
+          "[--rotations n] [--rounds n] [--threads n] [--seed n]]\n",
+          prog);
+  exit(1);
+}
+
 int main(int argc, char *argv[]) {
   signal(SIGINT, handle_signal);
+  signal(SIGPIPE, SIG_IGN); // A vanished client must not kill its handler
 
   // Register SIGCHLD handler to reap zombies
   struct sigaction sa;
@@ -431,43 +1160,165 @@ int main(int argc, char *argv[]) {
 
   // Parse arguments
   int players_needed = MIN_PLAYERS; // Default
-  if (argc > 1) {
-    players_needed = atoi(argv[1]);
-    if (players_needed < MIN_PLAYERS || players_needed > MAX_PLAYERS) {
-      fprintf(stderr, "Usage: %s [num_players 3-5]\n", argv[0]);
+  int takeover = 0;
+  int sim_games = 0;
+  unsigned int sim_seed = 1;
+  int sim_greedy = 0;
+  int sim_matches = 1;
+  TournamentConfig tourney = {.format = TOURNEY_ROUND_ROBIN, .rotations = 1};
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--state-file") == 0 && i + 1 < argc) {
+      state_path = argv[++i];
+    } else if (strcmp(argv[i], "--takeover") == 0) {
+      takeover = 1;
+    } else if (strcmp(argv[i], "--tcp") == 0 && i + 1 < argc) {
+      tcp_port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+      bind_address = argv[++i];
+    } else if (strcmp(argv[i], "--ratings") == 0 && i + 1 < argc) {
+      ratings_path = argv[++i];
+    } else if (strcmp(argv[i], "--sim") == 0 && i + 1 < argc) {
+      sim_games = atoi(argv[++i]);
+      if (sim_games < 1)
+        usage(argv[0]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      sim_seed = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--greedy") == 0 && i + 1 < argc) {
+      sim_greedy = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+      sim_matches = atoi(argv[++i]);
+      if (sim_matches < 1)
+        usage(argv[0]);
+    } else if (strcmp(argv[i], "--tournament") == 0 && i + 1 < argc) {
+      tourney.roster_path = argv[++i];
+    } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      tourney.format = tournament_format(argv[++i]);
+      if (tourney.format == -1)
+        usage(argv[0]);
+    } else if (strcmp(argv[i], "--rotations") == 0 && i + 1 < argc) {
+      tourney.rotations = atoi(argv[++i]);
+      if (tourney.rotations < 1)
+        usage(argv[0]);
+    } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+      tourney.rounds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      tourney.threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+      game_cpus = argv[++i];
+    } else if (strcmp(argv[i], "--io-cpus") == 0 && i + 1 < argc) {
+      io_cpus = argv[++i];
+    } else if (strcmp(argv[i], "--io") == 0 && i + 1 < argc) {
+      io_backend = strcmp(argv[++i], "uring") == 0 ? IO_URING : IO_BLOCKING;
+    } else if (argv[i][0] != '-') {
+      players_needed = atoi(argv[i]);
+      if (players_needed < MIN_PLAYERS || players_needed > MAX_PLAYERS) {
+        usage(argv[0]);
+      }
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  if (io_cpus && !game_cpus)
+    usage(argv[0]); // --io-cpus only splits a --cpus placement
+
+  // Tournament: bot roster on worker threads, no sockets or IPC
+  if (tourney.roster_path) {
+    tourney.players = players_needed;
+    tourney.seed = sim_seed;
+    return tournament_run(&tourney) == 0 ? 0 : 1;
+  }
+
+  // Simulation: in-process bots on virtual time, no sockets or IPC
+  if (sim_games)
+    return sim_run(players_needed, sim_games, sim_seed, sim_greedy,
+                   sim_matches);
+
+  instance_name(shm_name, sizeof(shm_name), SHM_NAME);
+  instance_name(scheduler_sem_name, sizeof(scheduler_sem_name),
+                SEM_SCHEDULER_NAME);
+  instance_name(upgrade_path, sizeof(upgrade_path), UPGRADE_SOCKET_PATH);
+  instance_name(admin_path, sizeof(admin_path), ADMIN_SOCKET_PATH);
+  instance_name(score_path, sizeof(score_path), SCORE_FILE);
+  instance_name(log_path, sizeof(log_path), LOG_FILE);
+
+  // Hot upgrade: receive the match from the running server first
+  HandoffInfo handoff;
+  int handoff_conn = -1;
+  int handoff_socks[MAX_PLAYERS];
+  if (takeover) {
+    handoff_conn = handoff_connect(upgrade_path);
+    if (handoff_conn == -1)
+      ERR_EXIT("connect to running server");
+    if (handoff_recv(handoff_conn, &handoff, &server_socket, handoff_socks) ==
+        -1) {
+      fprintf(stderr, "[Server] Invalid handoff from running server\n");
       exit(1);
     }
+    players_needed = handoff.player_count;
+    state_path = handoff.state_path[0] ? handoff.state_path : NULL;
   }
 
   printf("[Server] Starting Mega Tic-Tac-Toe Server for %d players...\n",
          players_needed);
 
-  // 0. Setup Logger Pipe
-  if (pipe(log_pipe) == -1) {
-    ERR_EXIT("pipe");
+  if (placement_configure(game_cpus, io_cpus) == -1) {
+    fprintf(stderr, "[Server] Bad CPU list or CPUs not available\n");
+    exit(1);
   }
 
-  // 1. Setup Shared Memory
-  shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
-  if (shm_fd == -1)
-    ERR_EXIT("shm_open");
-  ftruncate(shm_fd, sizeof(GameState));
+  // 0. Setup Logger Pipe
+  logger_init(log_path, io_backend);
+
+  // 1. Setup Shared Memory (shm segment, or the state file if given)
+  // Created from a game core so its pages are first touched on that node
+  placement_pin_game();
+  int warm_start = 0;
+  game_state = state_store_open(shm_name, state_path, players_needed, takeover,
+                                &warm_start);
+  if (!game_state) {
+    // No ack: the old server resumes the match itself
+    fprintf(stderr, "[Server] Handed-over state is invalid. Aborting.\n");
+    exit(1);
+  }
+  turns.gs = game_state;
+  placement_bind_memory(game_state, sizeof(GameState));
+  // From here the main thread and the threads it starts do I/O
+  placement_pin_io();
+  if (takeover) {
+    send(handoff_conn, "OK\n", 3, 0);
+    close(handoff_conn);
+  }
 
-  game_state =
-      mmap(0, sizeof(GameState), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-  if (game_state == MAP_FAILED)
-    ERR_EXIT("mmap");
+  if (leaderboard_open(ratings_path) == -1)
+    perror("[Server] Ratings journal unavailable");
+  // Leaderboard queries (same owner-only Unix socket setup)
+  admin_socket = handoff_listen(admin_path);
+  if (admin_socket == -1)
+    perror("[Server] Admin socket unavailable");
 
-  // Initialize Game State
-  // Initialize Game State
-  init_game_state(game_state);
-  // Reset win counts
-  memset((void *)game_state->win_counts, 0, sizeof(game_state->win_counts));
-  load_scores(game_state); // Load historical data
+  if (!warm_start) {
+    // Win counts of a reattached state already include score.txt
+    load_scores(game_state); // Load historical data
+  }
 
   game_state->player_count = players_needed;
 
+  if (warm_start) {
+    // Nobody is connected to a reattached match yet: every seat is held for
+    // its player to RESUME (a takeover re-seats the handed-over ones below).
+    time_t now = vclock_now();
+    for (int i = 0; i < players_needed; i++) {
+      if (game_state->players[i].is_active) {
+        game_state->players[i].is_active = 0;
+        game_state->players[i].disconnected_at = now;
+      }
+    }
+  }
+
   // 2. Setup Mutex (Process Shared)
+  // Always (re)initialized: after a crash the old owner may have died holding
+  // it, and no other process maps the state yet.
   // sem_unlink(SEM_MUTEX_NAME);
   // mutex = sem_open(SEM_MUTEX_NAME, O_CREAT, 0666, 1);
   pthread_mutexattr_t mattr;
@@ -478,79 +1329,33 @@ int main(int argc, char *argv[]) {
 
   for (int i = 0; i < players_needed; i++) {
     char sem_name[64];
-    snprintf(sem_name, sizeof(sem_name), "%s%d", SEM_TURN_NAME_PREFIX, i);
+    turn_sem_name(sem_name, sizeof(sem_name), i);
     sem_unlink(sem_name);
     // Initialize to 0 (locked)
-    turn_sems[i] = sem_open(sem_name, O_CREAT, 0666, 0);
-    if (turn_sems[i] == SEM_FAILED)
+    turns.turn_sems[i] = sem_open(sem_name, O_CREAT, 0666, 0);
+    if (turns.turn_sems[i] == SEM_FAILED)
       ERR_EXIT("sem_open turn");
   }
 
   // Setup Scheduler Semaphore
-  sem_unlink(SEM_SCHEDULER_NAME);
-  sem_scheduler = sem_open(SEM_SCHEDULER_NAME, O_CREAT, 0666, 0);
-  if (sem_scheduler == SEM_FAILED)
+  sem_unlink(scheduler_sem_name);
+  turns.sem_scheduler = sem_open(scheduler_sem_name, O_CREAT, 0666, 0);
+  if (turns.sem_scheduler == SEM_FAILED)
     ERR_EXIT("sem_open scheduler");
 
-  // 3. Setup Socket (Unix Domain)
-  struct sockaddr_un address;
-  server_socket = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (server_socket == -1) // Corrected error check for socket
-    ERR_EXIT("socket");
-
-  // Clean up old socket file if it exists
-  unlink(SOCKET_PATH);
-
-  memset(&address, 0, sizeof(address));
-  address.sun_family = AF_UNIX;
-  strncpy(address.sun_path, SOCKET_PATH, sizeof(address.sun_path) - 1);
-
-  if (bind(server_socket, (struct sockaddr *)&address, sizeof(address)) < 0)
-    ERR_EXIT("bind");
-
-  // Set permissions so clients can access it
-  chmod(SOCKET_PATH, 0666);
-
-  if (listen(server_socket, 5) < 0)
-    ERR_EXIT("listen");
-
-  printf("[Server] Listening on %s. Waiting for players...\n", SOCKET_PATH);
-
-  // 4. Accept Players
-  int connected_count = 0;
-  char symbols[] = {'X', 'O', 'A', 'B', 'C'};
-
-  while (connected_count < players_needed && server_running) {
-    struct sockaddr_in client_addr;
-    socklen_t addrlen = sizeof(client_addr);
-    int new_socket =
-        accept(server_socket, (struct sockaddr *)&client_addr, &addrlen);
-    if (new_socket < 0)
-      ERR_EXIT("accept");
-
-    printf("[Server] Player %d connected!\n", connected_count + 1);
-    log_msg("[Connection] Player %d connected from %s\n", connected_count + 1,
-            "local");
-
-    pthread_mutex_lock(&game_state->game_mutex);
-    game_state->players[connected_count].id = connected_count + 1; // 1-based ID
-    game_state->players[connected_count].socket_fd = new_socket;
-    game_state->players[connected_count].symbol = symbols[connected_count];
-    game_state->players[connected_count].is_active = 1;
-    pthread_mutex_unlock(&game_state->game_mutex);
-
-    // Fork child process for this player
-    pid_t pid = fork();
-    if (pid == 0) {
-      // Child
-      handle_client(connected_count, new_socket);
-    } else if (pid < 0) {
-      ERR_EXIT("fork");
+  // 3. Setup Socket and 4. Accept Players, unless the match was handed over
+  if (takeover) {
+    for (int i = 0; i < handoff.seat_count; i++) {
+      int seat = handoff.seat_of[i];
+      game_state->players[seat].socket_fd = handoff_socks[i];
+      game_state->players[seat].is_active = 1;
+      spawn_handler(seat, handoff_socks[i]);
     }
-
-    // Parent continues
-    close(new_socket); // Parent doesn't need this specific socket fd
-    connected_count++;
+    printf("[Server] Took over %d players.\n", handoff.seat_count);
+    log_msg("[Upgrade] Took over match at turn %d\n", game_state->turn_count);
+  } else {
+    listen_for_players();
+    accept_players(players_needed);
   }
 
   printf("[Server] All players connected! Starting game...\n");
@@ -563,8 +1368,7 @@ int main(int argc, char *argv[]) {
   }
 
   // Start the Scheduler Thread
-  pthread_t scheduler_tid;
-  if (pthread_create(&scheduler_tid, NULL, scheduler_thread, NULL) != 0) {
+  if (pthread_create(&scheduler_tid, NULL, scheduler_thread, &turns) != 0) {
     ERR_EXIT("pthread_create scheduler");
   }
 
@@ -574,83 +1378,111 @@ int main(int argc, char *argv[]) {
   // Option B: Just signal Player 1 directly to start.
   // Let's signal Player 1 directly, as they are "Index 0".
   // The Scheduler picks up only after a turn is COMPLETED.
-  sem_post(turn_sems[0]);
+  // A reattached game resumes with whoever held the turn; a finished one is
+  // left to the monitor loop below, which records and resets it.
+  restart_turns(&turns, players_needed);
+
+  // Accept hot upgrades from here on (./server --takeover)
+  upgrade_socket = handoff_listen(upgrade_path);
+  if (upgrade_socket == -1)
+    perror("[Server] Upgrade socket unavailable");
 
   // Parent Process Monitor Loop
+  long long next_game_us = 0; // While a finished game is on show
   while (server_running) {
-    sleep(1);
+    // Sleeps 1s like before, but wakes up for reconnects, upgrades,
+    // connections still sending their opening line and the next game
+    struct pollfd pfds[3 + HELLO_PENDING_MAX] = {
+        {.fd = server_socket, .events = POLLIN},
+        {.fd = upgrade_socket, .events = POLLIN},
+        {.fd = admin_socket, .events = POLLIN}};
+    int wait_ms = 1000;
+    if (next_game_us) {
+      long long left = (next_game_us - vclock_now_us() + 999) / 1000;
+      wait_ms = left < wait_ms ? (left > 0 ? left : 0) : wait_ms;
+    }
+    int timeout = poll_greetings(pfds, 3, wait_ms);
+    int ready = poll(pfds, 3 + greeting_count, timeout);
     if (!server_running)
       break;
+    release_vacated_seats(players_needed, 1);
+    serve_greetings(pfds, 3, players_needed, 1);
+    if (ready > 0 && (pfds[0].revents & POLLIN)) {
+      int new_socket = accept(server_socket, NULL, NULL);
+      if (new_socket != -1)
+        greet(new_socket, 0);
+    }
+    if (ready > 0 && (pfds[2].revents & POLLIN)) {
+      int conn = accept(admin_socket, NULL, NULL);
+      if (conn != -1)
+        greet(conn, 1);
+    }
+    if (ready > 0 && (pfds[1].revents & POLLIN)) {
+      int conn = accept(upgrade_socket, NULL, NULL);
+      if (conn != -1) {
+        handed_off = hand_off(conn, players_needed) == 0;
+        close(conn);
+        if (handed_off)
+          break;
+      }
+      continue;
+    }
     pthread_mutex_lock(&game_state->game_mutex);
-    if (game_state->game_over) {
+    if (game_state->game_over && !next_game_us) {
       // Capture state atomically while holding lock
-      int winner = game_state->winner_id;
-      int turns = game_state->turn_count;
-      int total_wins = 0;
-
-      if (winner > 0 && winner <= game_state->player_count) {
-        game_state->win_counts[winner - 1]++; // Update in-memory score
-        total_wins = game_state->win_counts[winner - 1];
-      }
-
-      char winner_symbol = '?';
-      if (winner > 0 && winner <= game_state->player_count) {
-        winner_symbol = game_state->players[winner - 1].symbol;
-      }
+      GameResult result;
+      read_result(&turns, &result);
+      int winner = result.winner;
       pthread_mutex_unlock(&game_state->game_mutex);
 
-      printf("[Main] Game Over detected. Writing to score.txt...\n");
+      printf("[Main] Game Over detected. Writing to %s...\n", score_path);
       log_msg("[Game] Game Over. Winner: %d\n", winner);
 
-      FILE *fp = fopen("score.txt", "a");
-      if (fp) {
+      FILE *fp = result.already_saved ? NULL : fopen(score_path, "a");
+      if (result.already_saved) {
+        printf("[Main] Result already saved before restart.\n");
+      } else if (fp) {
         time_t now = time(NULL);
         char *time_str = ctime(&now);
         time_str[strlen(time_str) - 1] = '\0'; // Remove newline
 
         if (winner == 0) {
-          fprintf(fp, "[%s] Draw! Total Turns: %d\n", time_str, turns);
+          fprintf(fp, "[%s] Draw! Total Turns: %d\n", time_str, result.turns);
         } else {
           fprintf(fp,
                   "[%s] Winner: Player %d (%c) | Total Turns: %d | Total Wins: "
                   "%d\n",
-                  time_str, winner, winner_symbol, turns, total_wins);
+                  time_str, winner, result.winner_symbol, result.turns,
+                  result.total_wins);
         }
         fclose(fp);
+        rate_match(result.names, result.seats, winner);
         printf("[Main] Score saved.\n");
       } else {
-        perror("[Main] Failed to open score.txt");
+        perror("[Main] Failed to open score file");
       }
-
-      printf("[Main] Cleaning up in 5 seconds...\n");
-      sleep(5);
-
-      // RESET GAME STATE
+      // Only the monitor counts a result, after writing it out
       pthread_mutex_lock(&game_state->game_mutex);
-      printf("[Main] Resetting game state for new game...\n");
-      memset((void *)game_state->board, ' ', sizeof(game_state->board));
-      game_state->turn_count = 0;
-      game_state->winner_id = 0;
-      game_state->current_player_index = 0;
-      game_state->game_over = 0;
+      count_result(&turns);
       pthread_mutex_unlock(&game_state->game_mutex);
+      if (state_path && !result.already_saved)
+        state_store_sync(game_state);
 
-      printf("[Main] Draining semaphores to ensure clean state...\n");
-      // Drain Scheduler Semaphore
-      while (sem_trywait(sem_scheduler) == 0)
-        ;
-
-      // Drain Player Turn Semaphores
-      for (int i = 0; i < players_needed; i++) {
-        while (sem_trywait(turn_sems[i]) == 0)
-          ;
-      }
+      // The loop keeps serving connections and queries during the pause
+      printf("[Main] Cleaning up in %d seconds...\n", GAME_RESET_PAUSE_SEC);
+      next_game_us = vclock_now_us() + GAME_RESET_PAUSE_SEC * 1000000LL;
+      continue; // Lock already released above
+    }
+    pthread_mutex_unlock(&game_state->game_mutex);
 
+    if (next_game_us && vclock_now_us() >= next_game_us) {
+      next_game_us = 0;
+      // RESET GAME STATE, then signal Player 1 to start (or the next
+      // player still present) after draining stale posts
+      printf("[Main] Resetting game state for new game...\n");
+      start_next_game(&turns, players_needed);
       printf("[Main] Game State Reset. Signaling Player 1 to start.\n");
-      // Signal Player 1 to start
-      sem_post(turn_sems[0]);
     }
-    pthread_mutex_unlock(&game_state->game_mutex);
   }
 
   // Graceful Exit
@@ -662,10 +1494,20 @@ int main(int argc, char *argv[]) {
     }
     printf("--------------------------------\n");
   }
+  if (placement_enabled()) {
+    CpuUsage usage[PLACEMENT_MAX_CPUS];
+    int n = placement_usage(usage, PLACEMENT_MAX_CPUS, 1);
+    printf("[Server] CPU use since start:");
+    for (int i = 0; i < n; i++)
+      printf(" cpu%d(%s) %.1f%%", usage[i].cpu, usage[i].role, usage[i].busy);
+    printf("\n");
+  }
 
-  // Cancel and Join Threads
-  pthread_cancel(scheduler_tid);
-  pthread_join(scheduler_tid, NULL);
+  // Cancel and Join Threads (a handoff already stopped the scheduler)
+  if (!handed_off) {
+    pthread_cancel(scheduler_tid);
+    pthread_join(scheduler_tid, NULL);
+  }
   pthread_cancel(logger_tid);
   pthread_join(logger_tid, NULL);
 
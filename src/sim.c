@@ -0,0 +1,265 @@
+#include "../include/sim.h"
+#include "../include/bots.h"
+#include "../include/evaluator.h"
+#include "../include/game_logic.h"
+#include "../include/turns.h"
+#include "../include/vclock.h"
+
+#define SIM_DROP_ODDS 256   // A bot drops out on 1 in this many moves
+#define SIM_RANDOM_TRIES 8  // Random picks before taking the next free cell
+
+struct SimMatch;
+
+// One bot seat, run as a thread that follows the handler's protocol
+typedef struct {
+  struct SimMatch *match;
+  int seat;
+  int greedy; // Plays the evaluator's best move
+  unsigned int rng;
+  int misses; // Invalid picks in a row this turn
+  int invalid, drops, stalls;
+  pthread_t tid;
+} SimBot;
+
+// One simulated match: the server's state, semaphores and scheduler on a
+// virtual clock of its own, with bots in the seats
+typedef struct SimMatch {
+  GameState gs;
+  Turns turns;
+  VClock clock;
+  sem_t sems[MAX_PLAYERS + 2]; // Unnamed: the bots are threads
+  SimBot bots[MAX_PLAYERS];
+  int players, games, greedy;
+  unsigned int seed;
+  volatile int done;
+  // Moves, added by the seat holding the turn, and results, added by the
+  // monitor; the turn order serializes them
+  unsigned long long digest;
+  long long turns_played, virtual_us;
+  int draws;
+  pthread_t tid;
+} SimMatch;
+
+// A greedy bot moves like the tournament's (see bots.h). A random one
+// picks random cells like an impatient player; the server's rules reject
+// taken ones. After a few misses it takes the n-th free cell. The bot holds
+// the turn, so the board cannot change under it.
+static int bot_pick(SimBot *bot) {
+  GameState *gs = &bot->match->gs;
+  char board[BOARD_SIZE][BOARD_SIZE];
+
+  pthread_mutex_lock(&gs->game_mutex);
+  memcpy(board, (const void *)gs->board, sizeof(board));
+  int turn_count = gs->turn_count;
+  pthread_mutex_unlock(&gs->game_mutex);
+
+  if (bot->greedy)
+    return bot_move((const char(*)[BOARD_SIZE])board, bot->match->players,
+                    turn_count, bot->seat, 1, &bot->rng);
+
+  int pick = xorshift32(&bot->rng) % (BOARD_SIZE * BOARD_SIZE);
+  if (bot->misses >= SIM_RANDOM_TRIES)
+    pick = bot_free_cell((const char(*)[BOARD_SIZE])board,
+                         pick % (BOARD_SIZE * BOARD_SIZE - turn_count));
+  return pick;
+}
+
+// The handler's loop without the socket: wait for the turn, think, move.
+// With no board to redraw the bot sleeps until its turn is offered (after
+// a game over that is the next game's first turn). Now and then it drops
+// out after its move and comes back a few seconds later, like a RESUME
+// within the grace window.
+static void *bot_thread(void *arg) {
+  SimBot *bot = arg;
+  SimMatch *m = bot->match;
+  Turns *t = &m->turns;
+  int seat = bot->seat;
+
+  while (1) {
+    wait_for_turn(t, seat, -1);
+    if (m->done)
+      break;
+
+    if (bot->misses == 0) // A retry after INVALID is typed straight away
+      vclock_sleep_us(100000 + xorshift32(&bot->rng) % 900000); // Thinking
+    int pick = bot_pick(bot);
+    int row = pick / BOARD_SIZE, col = pick % BOARD_SIZE;
+    pthread_mutex_lock(&m->gs.game_mutex);
+    if (is_valid_move(&m->gs, row, col)) {
+      m->digest = digest_add(m->digest, seat);
+      m->digest = digest_add(m->digest, pick);
+    }
+    pthread_mutex_unlock(&m->gs.game_mutex);
+
+    if (play_move(t, seat, row, col) == MOVE_INVALID) {
+      // INVALID: the turn stays with us
+      bot->invalid++;
+      bot->misses++;
+      vclock_sem_post(t->turn_sems[seat]);
+      continue;
+    }
+    bot->misses = 0;
+
+    if (xorshift32(&bot->rng) % SIM_DROP_ODDS == 0) {
+      vacate_seat(t, seat, 0);
+      bot->drops++;
+      vclock_sleep(1 + xorshift32(&bot->rng) % (2 * m->players));
+      pthread_mutex_lock(&m->gs.game_mutex);
+      m->gs.players[seat].is_active = 1;
+      pthread_mutex_unlock(&m->gs.game_mutex);
+      bot->stalls += resume_turn(t, seat);
+    }
+  }
+  return NULL;
+}
+
+// Runs one match to the end: its thread is the monitor, the clock's
+// participant 0
+static void *match_thread(void *arg) {
+  SimMatch *m = arg;
+  GameState *gs = &m->gs;
+  Turns *t = &m->turns;
+  int players = m->players;
+  pthread_t scheduler;
+
+  init_game_state(gs);
+  pthread_mutex_init(&gs->game_mutex, NULL);
+  gs->player_count = players;
+  for (int i = 0; i < players + 2; i++)
+    sem_init(&m->sems[i], 0, 0);
+  t->gs = gs;
+  t->sem_scheduler = &m->sems[players];
+  t->sem_game_over = &m->sems[players + 1];
+  t->quiet = 1;
+  for (int i = 0; i < players; i++) {
+    SimBot *bot = &m->bots[i];
+    t->turn_sems[i] = &m->sems[i];
+    gs->players[i].id = i + 1;
+    gs->players[i].symbol = PLAYER_SYMBOLS[i];
+    gs->players[i].is_active = 1;
+    gs->players[i].socket_fd = -1;
+    memset(bot, 0, sizeof(SimBot));
+    bot->match = m;
+    bot->seat = i;
+    bot->greedy = i < m->greedy;
+    bot->rng = (m->seed + 1) * 2654435761u ^ (i + 1) * 40503u;
+    if (bot->rng == 0)
+      bot->rng = i + 1;
+  }
+  m->digest = DIGEST_INIT;
+  vclock_init(&m->clock);
+
+  // The server's threads, with bots in the handlers' place
+  for (int i = 0; i < players; i++) {
+    if (vclock_thread_create(&m->bots[i].tid, bot_thread, &m->bots[i]) != 0)
+      ERR_EXIT("pthread_create bot");
+  }
+  if (vclock_thread_create(&scheduler, scheduler_thread, t) != 0)
+    ERR_EXIT("pthread_create scheduler");
+  restart_turns(t, players);
+
+  // The monitor's part: count each finished game as its last move
+  // announces it, pause, start the next
+  for (int played = 0; played < m->games; played++) {
+    vclock_sem_wait(t->sem_game_over);
+    GameResult result;
+    pthread_mutex_lock(&gs->game_mutex);
+    read_result(t, &result);
+    count_result(t);
+    pthread_mutex_unlock(&gs->game_mutex);
+    m->turns_played += result.turns;
+    m->draws += result.winner == 0;
+    m->digest = digest_add(m->digest, result.winner);
+    if (played + 1 < m->games) {
+      vclock_sleep(GAME_RESET_PAUSE_SEC);
+      start_next_game(t, players);
+    }
+  }
+
+  // Every bot is waiting for a turn (or back from a drop soon): wake them
+  // to leave, then stop holding the clock. The scheduler is cancelled like
+  // the server's.
+  m->done = 1;
+  m->virtual_us = vclock_now_us();
+  for (int i = 0; i < players; i++)
+    vclock_sem_post(t->turn_sems[i]);
+  vclock_thread_exit();
+  for (int i = 0; i < players; i++)
+    pthread_join(m->bots[i].tid, NULL);
+  pthread_cancel(scheduler);
+  pthread_join(scheduler, NULL);
+
+  vclock_destroy(&m->clock);
+  for (int i = 0; i < players + 2; i++)
+    sem_destroy(&m->sems[i]);
+  pthread_mutex_destroy(&gs->game_mutex);
+  return NULL;
+}
+
+int sim_run(int players, int games, unsigned int seed, int greedy,
+            int matches) {
+  if (matches < 1)
+    matches = 1;
+  if (matches > games)
+    matches = games;
+  SimMatch *all = calloc(matches, sizeof(SimMatch));
+  if (!all)
+    ERR_EXIT("calloc");
+
+  printf("[Sim] %d games, %d players, seed %u", games, players, seed);
+  if (matches > 1)
+    printf(", %d matches in parallel", matches);
+  if (greedy > 0)
+    printf(", %d greedy (%s evaluator)", greedy, evaluator_name());
+  printf("\n");
+  double real_start = monotonic_seconds();
+
+  // Match m plays its share of the games from its own seed
+  for (int i = 0; i < matches; i++) {
+    SimMatch *m = &all[i];
+    m->players = players;
+    m->games = games / matches + (i < games % matches);
+    m->greedy = greedy;
+    m->seed = seed + i * 0x9E3779B9u;
+    if (pthread_create(&m->tid, NULL, match_thread, m) != 0)
+      ERR_EXIT("pthread_create match");
+  }
+
+  int wins[MAX_PLAYERS] = {0};
+  int invalid = 0, drops = 0, stalls = 0, draws = 0;
+  long long total_turns = 0, virtual_us = 0;
+  unsigned long long digest = DIGEST_INIT;
+  for (int i = 0; i < matches; i++) {
+    SimMatch *m = &all[i];
+    pthread_join(m->tid, NULL);
+    for (int s = 0; s < players; s++) {
+      wins[s] += m->gs.win_counts[s];
+      invalid += m->bots[s].invalid;
+      drops += m->bots[s].drops;
+      stalls += m->bots[s].stalls;
+    }
+    draws += m->draws;
+    total_turns += m->turns_played;
+    if (m->virtual_us > virtual_us)
+      virtual_us = m->virtual_us;
+    digest = digest_add(digest, (int)m->digest);
+    digest = digest_add(digest, (int)(m->digest >> 32));
+  }
+  double real_sec = monotonic_seconds() - real_start;
+
+  for (int i = 0; i < players; i++)
+    printf("[Sim] Player %d (%c): %d wins\n", i + 1, PLAYER_SYMBOLS[i],
+           wins[i]);
+  printf("[Sim] Draws: %d\n", draws);
+  printf("[Sim] Turns: %lld (%.1f per game), %d invalid, %d drops, "
+         "%d stalls\n",
+         total_turns, games ? (double)total_turns / games : 0.0, invalid,
+         drops, stalls);
+  printf("[Sim] Virtual time: %lld s%s, real time: %.3f s (%.0f games/s)\n",
+         virtual_us / 1000000, matches > 1 ? " (longest match)" : "",
+         real_sec, real_sec > 0 ? games / real_sec : 0.0);
+  printf("[Sim] Digest: %016llx\n", digest);
+
+  free(all);
+  return 0;
+}
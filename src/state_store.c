@@ -0,0 +1,126 @@
+#include "../include/state_store.h"
+#include "../include/game_logic.h"
+#include <unistd.h>
+
+static int store_fd = -1;
+static char store_shm_name[64] = SHM_NAME;
+
+// Checks that a reattached state is a game this server can continue.
+// The caller holds no locks; nobody else has the mapping yet.
+int state_store_validate(GameState *gs, int players_needed) {
+  if (gs->magic != STATE_MAGIC || gs->version != STATE_VERSION)
+    return 0;
+  if (gs->player_count != players_needed)
+    return 0;
+  if (gs->current_player_index < 0 ||
+      gs->current_player_index >= gs->player_count)
+    return 0;
+  if (gs->winner_id < 0 || gs->winner_id > gs->player_count)
+    return 0;
+
+  int stones = 0;
+  for (int r = 0; r < BOARD_SIZE; r++) {
+    for (int c = 0; c < BOARD_SIZE; c++) {
+      char cell = gs->board[r][c];
+      if (cell == ' ')
+        continue;
+      if (!memchr(PLAYER_SYMBOLS, cell, gs->player_count))
+        return 0; // Not a symbol of this match
+      stones++;
+    }
+  }
+  if (stones != gs->turn_count)
+    return 0;
+
+  for (int i = 0; i < gs->player_count; i++) {
+    Player *p = &gs->players[i];
+    if (p->id != i + 1 || p->symbol != PLAYER_SYMBOLS[i])
+      return 0;
+    SeatInput *in = &gs->seat_input[i];
+    if (in->premove_count < 0 || in->premove_count > PREMOVE_MAX ||
+        in->input_len < 0 || in->input_len >= BUFFER_SIZE)
+      return 0;
+  }
+  return 1;
+}
+
+GameState *state_store_open(const char *shm_name, const char *state_path,
+                            int players_needed, int reuse_shm, int *warm) {
+  *warm = 0;
+  strncpy(store_shm_name, shm_name, sizeof(store_shm_name) - 1);
+
+  if (state_path) {
+    store_fd = open(state_path, O_CREAT | O_RDWR, 0666);
+    if (store_fd == -1)
+      ERR_EXIT("open state file");
+  } else {
+    store_fd = shm_open(store_shm_name, O_CREAT | O_RDWR, 0666);
+    if (store_fd == -1)
+      ERR_EXIT("shm_open");
+  }
+
+  struct stat st;
+  if (fstat(store_fd, &st) == -1)
+    ERR_EXIT("fstat");
+  off_t old_size = st.st_size;
+
+  if (ftruncate(store_fd, sizeof(GameState)) == -1)
+    ERR_EXIT("ftruncate");
+
+  GameState *gs = mmap(0, sizeof(GameState), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, store_fd, 0);
+  if (gs == MAP_FAILED)
+    ERR_EXIT("mmap");
+
+  // Only a mapping of exactly our layout can hold a previous game. The shm
+  // segment is started fresh unless a server is handing it over.
+  const char *where = state_path ? state_path : store_shm_name;
+  if ((state_path || reuse_shm) && old_size == sizeof(GameState)) {
+    if (state_store_validate(gs, players_needed)) {
+      *warm = 1;
+      printf("[Server] Reattached to game in %s (turn %d, %s)\n", where,
+             gs->turn_count, gs->game_over ? "finished" : "in progress");
+    } else {
+      printf("[Server] State in %s failed validation. Starting fresh.\n",
+             where);
+    }
+  }
+
+  // A handed-over segment is never wiped: the caller gives up instead.
+  if (reuse_shm && !*warm) {
+    state_store_detach(gs);
+    return NULL;
+  }
+
+  if (!*warm) {
+    init_game_state(gs);
+    memset((void *)gs->win_counts, 0, sizeof(gs->win_counts));
+    memset(gs->players, 0, sizeof(gs->players));
+  }
+  return gs;
+}
+
+// Flushes the mapping to disk. A server crash alone loses nothing (the page
+// cache keeps the pages); this covers the host going down after a result.
+void state_store_sync(GameState *gs) {
+  if (msync(gs, sizeof(GameState), MS_SYNC) == -1)
+    perror("msync");
+}
+
+// Unmaps the state but leaves it in place for another server
+void state_store_detach(GameState *gs) {
+  if (gs)
+    munmap(gs, sizeof(GameState));
+  if (store_fd != -1)
+    close(store_fd);
+  store_fd = -1;
+}
+
+void state_store_close(GameState *gs, const char *state_path) {
+  if (gs && state_path)
+    state_store_sync(gs);
+  state_store_detach(gs);
+  // The state file is kept so the next start can resume from it.
+  if (!state_path)
+    shm_unlink(store_shm_name);
+}
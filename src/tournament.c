@@ -0,0 +1,422 @@
+#include "../include/tournament.h"
+#include "../include/bots.h"
+#include "../include/evaluator.h"
+#include "../include/match_slab.h"
+#include <math.h>
+#include <unistd.h>
+
+#define WILSON_Z 1.96 // 95% intervals
+
+typedef struct {
+  char name[NAME_LEN];
+  char kind[16]; // As written in the roster
+  int greedy_top; // 0: random moves, N: one of the evaluator's N best
+  int games, wins, draws, byes;
+} Entrant;
+
+// One seat rotation of one table: `players` games, the table's bots moving
+// one seat on each game
+typedef struct {
+  int seats[MAX_PLAYERS]; // Entrants, in seat order for the first game
+  unsigned int seed;
+  int wins[MAX_PLAYERS];      // By slot in seats[]
+  int seat_wins[MAX_PLAYERS]; // By seat, for the first-move advantage
+  int draws;
+  unsigned long long digest; // Every move and result of the job
+} Job;
+
+// A batch of jobs the workers pull from until it runs dry
+typedef struct {
+  Job *jobs;
+  int count;
+  int next; // Next unclaimed job, taken atomically
+  int players;
+  const Entrant *roster;
+  MatchSlab *slabs; // One per worker thread
+} Batch;
+
+typedef struct {
+  Batch *batch;
+  MatchSlab *slab;
+  long long match; // The worker's match in its slab
+} Worker;
+
+// A job's seed depends only on its place in the schedule
+static unsigned int job_seed(unsigned int seed, int round, int index) {
+  unsigned int s = (seed + 1) * 2654435761u ^ (round + 1) * 2246822519u ^
+                   (index + 1) * 3266489917u;
+  xorshift32(&s);
+  return s ? s : 1;
+}
+
+int tournament_format(const char *name) {
+  if (strcmp(name, "roundrobin") == 0)
+    return TOURNEY_ROUND_ROBIN;
+  if (strcmp(name, "swiss") == 0)
+    return TOURNEY_SWISS;
+  if (strcmp(name, "rotate") == 0)
+    return TOURNEY_ROTATE;
+  return -1;
+}
+
+static int load_roster(const char *path, Entrant *roster) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    perror(path);
+    return -1;
+  }
+
+  char line[128];
+  int count = 0, line_no = 0;
+  while (fgets(line, sizeof(line), fp)) {
+    Entrant e;
+    line_no++;
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = '\0';
+    memset(&e, 0, sizeof(e));
+    int fields = sscanf(line, "%31s %15s", e.name, e.kind);
+    if (fields <= 0)
+      continue; // Blank or comment
+    if (fields == 1)
+      strcpy(e.kind, "random");
+
+    if (strcmp(e.kind, "random") == 0)
+      e.greedy_top = 0;
+    else if (strcmp(e.kind, "greedy") == 0)
+      e.greedy_top = 1;
+    else if (sscanf(e.kind, "greedy%d", &e.greedy_top) != 1 ||
+             e.greedy_top < 1 || e.greedy_top > HINT_MAX)
+      e.greedy_top = -1;
+    if (e.greedy_top < 0 || count == ROSTER_MAX) {
+      fprintf(stderr, "[Tournament] %s:%d: %s\n", path, line_no,
+              count == ROSTER_MAX ? "roster too long" : "unknown bot");
+      fclose(fp);
+      return -1;
+    }
+    roster[count++] = e;
+  }
+  fclose(fp);
+  return count;
+}
+
+static void play_job(MatchSlab *slab, long long match, const Batch *batch,
+                     Job *job) {
+  int players = batch->players;
+  unsigned int rng = job->seed;
+  unsigned long long digest = DIGEST_INIT;
+
+  for (int shift = 0; shift < players; shift++) {
+    // Seat s goes to slot (s + shift) % players
+    for (int seat = 0; seat < players; seat++)
+      match_slab_set_bot(
+          slab, match, seat,
+          batch->roster[job->seats[(seat + shift) % players]].greedy_top);
+    int winner = bot_play_game(slab, match, &rng, &digest);
+    if (winner > 0) {
+      job->wins[(winner - 1 + shift) % players]++;
+      job->seat_wins[winner - 1]++;
+    } else {
+      job->draws++;
+    }
+  }
+  job->digest = digest;
+}
+
+static void *worker_thread(void *arg) {
+  Worker *w = arg;
+  Batch *batch = w->batch;
+
+  int i;
+  while ((i = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED)) <
+         batch->count)
+    play_job(w->slab, w->match, batch, &batch->jobs[i]);
+  return NULL;
+}
+
+// Each worker plays its jobs on a match of its own slab, taken here and
+// given back once the batch is done. Boards are packed 144 bytes apart, so
+// workers sharing one slab would write to the same cache lines on every
+// move; separate slabs keep each worker's match on its own lines.
+static void run_batch(Batch *batch, int threads) {
+  pthread_t tids[TOURNEY_THREADS_MAX];
+  Worker workers[TOURNEY_THREADS_MAX];
+  if (threads > batch->count)
+    threads = batch->count;
+  batch->next = 0;
+  for (int t = 0; t < threads; t++) {
+    workers[t].batch = batch;
+    workers[t].slab = &batch->slabs[t];
+    workers[t].match = match_slab_alloc(workers[t].slab, batch->players);
+    if (workers[t].match == -1) {
+      fprintf(stderr, "[Tournament] Match slab is full\n");
+      exit(EXIT_FAILURE);
+    }
+    if (pthread_create(&tids[t], NULL, worker_thread, &workers[t]) != 0)
+      ERR_EXIT("pthread_create worker");
+  }
+  for (int t = 0; t < threads; t++) {
+    pthread_join(tids[t], NULL);
+    match_slab_free(workers[t].slab, workers[t].match);
+  }
+}
+
+// Adds a finished batch to the standings, in schedule order
+static unsigned long long tally(const Batch *batch, Entrant *roster,
+                                int *seat_wins, int *draws,
+                                unsigned long long digest) {
+  for (int j = 0; j < batch->count; j++) {
+    const Job *job = &batch->jobs[j];
+    for (int s = 0; s < batch->players; s++) {
+      Entrant *e = &roster[job->seats[s]];
+      e->games += batch->players;
+      e->wins += job->wins[s];
+      e->draws += job->draws;
+      seat_wins[s] += job->seat_wins[s];
+    }
+    *draws += job->draws;
+    digest = digest_add(digest, (int)job->digest);
+    digest = digest_add(digest, (int)(job->digest >> 32));
+  }
+  return digest;
+}
+
+static double score_of(const Entrant *e, int players) {
+  return e->wins + (double)e->draws / players;
+}
+
+static double rate_of(const Entrant *e, int players) {
+  return e->games ? score_of(e, players) / e->games : 0.0;
+}
+
+// Swiss order: best score rate first, roster order on ties
+static int by_rate_players;
+static const Entrant *by_rate_roster;
+static int by_rate(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  double rx = rate_of(&by_rate_roster[x], by_rate_players);
+  double ry = rate_of(&by_rate_roster[y], by_rate_players);
+  if (rx != ry)
+    return rx > ry ? -1 : 1;
+  return x - y;
+}
+
+// Tables for the next Swiss round. The leftover seats' byes go to the
+// lowest ranked who had the fewest; then each table is headed by the best
+// ranked bot left and filled with the best ranked of those who have met
+// its bots the fewest times (met[][], kept by the caller), so rematches
+// only happen when every choice is one.
+static int swiss_tables(Entrant *roster, int n, int players, int *order,
+                        int met[][ROSTER_MAX]) {
+  int byes = n % players, fewest = n;
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+  by_rate_players = players;
+  by_rate_roster = roster;
+  qsort(order, n, sizeof(int), by_rate);
+
+  for (int i = 0; i < n; i++)
+    if (roster[i].byes < fewest)
+      fewest = roster[i].byes;
+  int taken = 0;
+  for (int pass = fewest; taken < byes; pass++) {
+    for (int i = n - 1; i >= 0 && taken < byes; i--) {
+      if (order[i] >= 0 && roster[order[i]].byes == pass) {
+        roster[order[i]].byes++;
+        order[i] = -1;
+        taken++;
+      }
+    }
+  }
+  int kept = 0;
+  for (int i = 0; i < n; i++)
+    if (order[i] >= 0)
+      order[kept++] = order[i];
+
+  for (int i = 0; i < kept; i++) {
+    int head = i - i % players;
+    if (i == head)
+      continue;
+    int best = i, fewest_met = -1;
+    for (int j = i; j < kept; j++) {
+      int m = 0;
+      for (int k = head; k < i; k++)
+        m += met[order[k]][order[j]];
+      if (fewest_met < 0 || m < fewest_met) {
+        best = j;
+        fewest_met = m;
+      }
+    }
+    // Moved up to the seat; the rest keep their ranking order
+    int pick = order[best];
+    memmove(&order[i + 1], &order[i], sizeof(int) * (best - i));
+    order[i] = pick;
+  }
+  return kept / players;
+}
+
+static void print_standings(Entrant *roster, int n, int players) {
+  int order[ROSTER_MAX];
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+  by_rate_players = players;
+  by_rate_roster = roster;
+  qsort(order, n, sizeof(int), by_rate);
+
+  printf("[Tournament] Standings (score = wins + draws/%d, 95%% Wilson "
+         "interval):\n",
+         players);
+  printf("%3s  %-20s %-9s %7s %7s %6s %7s  %s\n", "#", "Name", "Bot", "Games",
+         "Wins", "Draws", "Score%", "95% CI");
+  for (int i = 0; i < n; i++) {
+    const Entrant *e = &roster[order[i]];
+    double p = rate_of(e, players), g = e->games;
+    double lo = 0, hi = 0;
+    if (g > 0) {
+      double z2 = WILSON_Z * WILSON_Z;
+      double center = (p + z2 / (2 * g)) / (1 + z2 / g);
+      double half = WILSON_Z * sqrt(p * (1 - p) / g + z2 / (4 * g * g)) /
+                    (1 + z2 / g);
+      lo = center - half;
+      hi = center + half;
+    }
+    printf("%3d  %-20s %-9s %7d %7d %6d %7.1f  [%.1f, %.1f]", i + 1, e->name,
+           e->kind, e->games, e->wins, e->draws, 100 * p, 100 * lo, 100 * hi);
+    if (e->byes)
+      printf("  %d bye%s", e->byes, e->byes > 1 ? "s" : "");
+    printf("\n");
+  }
+}
+
+int tournament_run(const TournamentConfig *cfg) {
+  static Entrant roster[ROSTER_MAX];
+  static int met[ROSTER_MAX][ROSTER_MAX]; // Games two bots shared a table
+  int players = cfg->players, rotations = cfg->rotations;
+  int n = load_roster(cfg->roster_path, roster);
+  if (n < 0)
+    return -1;
+  if (n < players || (cfg->format == TOURNEY_ROTATE && n != players)) {
+    fprintf(stderr, "[Tournament] %s needs %s %d bots, the roster has %d\n",
+            cfg->format == TOURNEY_ROTATE ? "rotate" : "This format",
+            cfg->format == TOURNEY_ROTATE ? "exactly" : "at least", players,
+            n);
+    return -1;
+  }
+
+  // Tables per round, and rounds
+  double tables = 1;
+  int rounds = 1;
+  if (cfg->format == TOURNEY_ROUND_ROBIN) {
+    for (int i = 0; i < players; i++)
+      tables = tables * (n - i) / (i + 1); // n choose players
+  } else if (cfg->format == TOURNEY_SWISS) {
+    tables = n / players;
+    rounds = cfg->rounds;
+    if (rounds < 1) // Enough for one bot to outscore the rest
+      rounds = (int)ceil(log2(n)) + 1;
+  }
+  double total_games = tables * rounds * rotations * players;
+  if (total_games > TOURNEY_MAX_GAMES) {
+    fprintf(stderr, "[Tournament] %.0f games is too many (max %d)\n",
+            total_games, TOURNEY_MAX_GAMES);
+    return -1;
+  }
+
+  int threads = cfg->threads;
+  if (threads < 1)
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1)
+    threads = 1;
+  if (threads > TOURNEY_THREADS_MAX)
+    threads = TOURNEY_THREADS_MAX;
+
+  Batch batch;
+  batch.count = (int)tables * rotations;
+  batch.players = players;
+  batch.roster = roster;
+  batch.jobs = calloc(batch.count, sizeof(Job));
+  if (!batch.jobs)
+    ERR_EXIT("calloc jobs");
+  batch.slabs = calloc(threads, sizeof(MatchSlab));
+  if (!batch.slabs)
+    ERR_EXIT("calloc slabs");
+  for (int t = 0; t < threads; t++) {
+    if (match_slab_init(&batch.slabs[t], 1, 0) == -1)
+      ERR_EXIT("match_slab_init");
+  }
+
+  const char *format_names[] = {"round-robin", "swiss", "rotate"};
+  evaluator_init(EVAL_BEST); // Before the workers share it
+  printf("[Tournament] %s, %d bots, %d per table, %.0f games on %d threads "
+         "(seed %u, %s evaluator)\n",
+         format_names[cfg->format], n, players, total_games, threads,
+         cfg->seed, evaluator_name());
+
+  int seat_wins[MAX_PLAYERS] = {0}, draws = 0;
+  unsigned long long digest = DIGEST_INIT;
+  double start = monotonic_seconds();
+  memset(met, 0, sizeof(met));
+
+  for (int round = 0; round < rounds; round++) {
+    int order[ROSTER_MAX], groups[MAX_PLAYERS];
+    int table_count;
+
+    if (cfg->format == TOURNEY_SWISS) {
+      table_count = swiss_tables(roster, n, players, order, met);
+    } else {
+      table_count = (int)tables;
+      for (int i = 0; i < players; i++)
+        groups[i] = i; // First combination (rotate: the whole roster)
+    }
+
+    for (int t = 0, j = 0; t < table_count; t++) {
+      int seats[MAX_PLAYERS];
+      if (cfg->format == TOURNEY_SWISS) {
+        memcpy(seats, &order[t * players], sizeof(int) * players);
+        for (int a = 0; a < players; a++)
+          for (int b = 0; b < players; b++)
+            if (a != b)
+              met[seats[a]][seats[b]]++;
+      } else {
+        memcpy(seats, groups, sizeof(int) * players);
+        // Next combination in lexicographic order
+        int i = players - 1;
+        while (i >= 0 && groups[i] == n - players + i)
+          i--;
+        if (i >= 0) {
+          groups[i]++;
+          for (int k = i + 1; k < players; k++)
+            groups[k] = groups[k - 1] + 1;
+        }
+      }
+      for (int r = 0; r < rotations; r++, j++) {
+        Job *job = &batch.jobs[j];
+        memset(job, 0, sizeof(*job));
+        memcpy(job->seats, seats, sizeof(seats));
+        job->seed = job_seed(cfg->seed, round, j);
+      }
+    }
+
+    batch.count = table_count * rotations;
+    run_batch(&batch, threads);
+    digest = tally(&batch, roster, seat_wins, &draws, digest);
+  }
+
+  double elapsed = monotonic_seconds() - start;
+  print_standings(roster, n, players);
+
+  printf("[Tournament] Wins by seat:");
+  for (int s = 0; s < players; s++)
+    printf(" %c %.1f%%,", PLAYER_SYMBOLS[s], 100.0 * seat_wins[s] / total_games);
+  printf(" draws %.1f%%\n", 100.0 * draws / total_games);
+  printf("[Tournament] %.0f games in %.3f s (%.0f games/s, %d threads)\n",
+         total_games, elapsed, elapsed > 0 ? total_games / elapsed : 0.0,
+         threads);
+  printf("[Tournament] Digest: %016llx\n", digest);
+
+  for (int t = 0; t < threads; t++)
+    match_slab_destroy(&batch.slabs[t]);
+  free(batch.slabs);
+  free(batch.jobs);
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include "../include/turns.h"
+#include "../include/game_logic.h"
+#include "../include/logger.h"
+#include "../include/vclock.h"
+
+// Caller holds game_mutex, so a seat being vacated sees either no offer or
+// an already posted one
+int offer_turn(Turns *t, int seat) {
+  int next = next_seat(t->gs, seat);
+  if (next == -1) {
+    t->gs->turn_stalled = 1;
+    return -1;
+  }
+  t->gs->current_player_index = next;
+  t->gs->turn_stalled = 0;
+  if (vclock_sem_post(t->turn_sems[next]) == -1) {
+    perror("sem_post turn_sems");
+  }
+  return next;
+}
+
+// Round Robin Scheduler Thread
+void *scheduler_thread(void *arg) {
+  Turns *t = arg;
+  GameState *gs = t->gs;
+  if (!t->quiet)
+    printf("[Scheduler] Thread started. Controlling turn order.\n");
+
+  while (1) {
+    // Wait for a player to finish their turn
+    if (vclock_sem_wait(t->sem_scheduler) == -1) {
+      if (errno != EINTR)
+        perror("sem_wait scheduler");
+      continue;
+    }
+
+    pthread_mutex_lock(&gs->game_mutex);
+    if (gs->game_over) {
+      pthread_mutex_unlock(&gs->game_mutex);
+      // The next game's first turn is offered by restart_turns()
+      if (!t->quiet)
+        printf("[Scheduler] Game Over detected. Waiting for the next "
+               "game...\n");
+      continue;
+    }
+
+    // Determine next player (Round Robin, absent seats skipped)
+    int current_id = gs->current_player_index; // 0-based index
+    int next_id = offer_turn(t, (current_id + 1) % gs->player_count);
+    pthread_mutex_unlock(&gs->game_mutex);
+
+    if (next_id == -1) {
+      if (!t->quiet)
+        printf("[Scheduler] No players present. Waiting for a reconnect.\n");
+      log_msg("[Scheduler] Turn stalled, all seats absent\n");
+      continue;
+    }
+
+    if (!t->quiet)
+      printf("[Scheduler] Signaling Player %d (Index %d) to go next.\n",
+             next_id + 1, next_id);
+    log_msg("[Scheduler] Player %d (%d) -> Player %d (%d)\n", current_id + 1,
+            current_id, next_id + 1, next_id);
+  }
+  return NULL;
+}
+
+// Hands the signal to whoever holds the turn, after dropping stale posts
+void restart_turns(Turns *t, int players_needed) {
+  while (sem_trywait(t->sem_scheduler) == 0)
+    ;
+  pthread_mutex_lock(&t->gs->game_mutex);
+  for (int i = 0; i < players_needed; i++) {
+    while (sem_trywait(t->turn_sems[i]) == 0)
+      ;
+  }
+  if (!t->gs->game_over)
+    offer_turn(t, t->gs->current_player_index);
+  pthread_mutex_unlock(&t->gs->game_mutex);
+}
+
+int wait_for_turn(Turns *t, int seat, long us) {
+  if (us < 0)
+    return vclock_sem_wait(t->turn_sems[seat]);
+  return vclock_sem_timedwait(t->turn_sems[seat], us);
+}
+
+int play_move(Turns *t, int seat, int row, int col) {
+  GameState *gs = t->gs;
+  Player *me = &gs->players[seat];
+
+  pthread_mutex_lock(&gs->game_mutex);
+  int result = apply_move(gs, seat, row, col);
+  if (result != MOVE_INVALID) {
+    log_msg("[Gameplay] Player %d placed '%c' at (%d, %d)\n", me->id,
+            me->symbol, row, col);
+    if (result == MOVE_WIN && !t->quiet) {
+      printf("[Server] Player %d WINS!\n", me->id);
+    } else if (result == MOVE_DRAW && !t->quiet) {
+      printf("[Server] Draw!\n");
+    }
+    if (result != MOVE_PLACED && t->sem_game_over)
+      vclock_sem_post(t->sem_game_over);
+    // Next player logic handled by Scheduler
+    if (vclock_sem_post(t->sem_scheduler) == -1)
+      perror("sem_post scheduler"); // Signal Scheduler
+  }
+  pthread_mutex_unlock(&gs->game_mutex);
+  return result;
+}
+
+void vacate_seat(Turns *t, int seat, int holding_turn) {
+  GameState *gs = t->gs;
+  Player *me = &gs->players[seat];
+
+  pthread_mutex_lock(&gs->game_mutex);
+  me->is_active = 0;
+  me->disconnected_at = vclock_now();
+  if (!holding_turn && sem_trywait(t->turn_sems[seat]) == 0)
+    holding_turn = 1;
+  if (holding_turn && !gs->game_over) {
+    if (vclock_sem_post(t->sem_scheduler) == -1)
+      perror("sem_post scheduler");
+  }
+  pthread_mutex_unlock(&gs->game_mutex);
+}
+
+int resume_turn(Turns *t, int seat) {
+  pthread_mutex_lock(&t->gs->game_mutex);
+  int stalled = t->gs->turn_stalled && !t->gs->game_over;
+  if (stalled)
+    offer_turn(t, seat);
+  pthread_mutex_unlock(&t->gs->game_mutex);
+  return stalled;
+}
+
+void read_result(Turns *t, GameResult *result) {
+  GameState *gs = t->gs;
+  int winner = gs->winner_id;
+
+  memset(result, 0, sizeof(*result));
+  result->winner = winner;
+  result->turns = gs->turn_count;
+  result->seats = gs->player_count;
+  result->already_saved = gs->result_saved;
+  result->winner_symbol = '?';
+  for (int i = 0; i < gs->player_count; i++)
+    memcpy(result->names[i], gs->players[i].name, NAME_LEN);
+
+  if (winner > 0 && winner <= gs->player_count) {
+    result->total_wins = gs->win_counts[winner - 1];
+    if (!result->already_saved)
+      result->total_wins++; // Not counted yet
+    result->winner_symbol = gs->players[winner - 1].symbol;
+  }
+}
+
+void count_result(Turns *t) {
+  GameState *gs = t->gs;
+  int winner = gs->winner_id;
+
+  if (gs->result_saved)
+    return;
+  if (winner > 0 && winner <= gs->player_count)
+    gs->win_counts[winner - 1]++; // Update in-memory score
+  gs->result_saved = 1;
+}
+
+void start_next_game(Turns *t, int players_needed) {
+  pthread_mutex_lock(&t->gs->game_mutex);
+  reset_game(t->gs);
+  pthread_mutex_unlock(&t->gs->game_mutex);
+  restart_turns(t, players_needed);
+}
@@ -0,0 +1,232 @@
+#include "../include/uring_io.h"
+#include <unistd.h>
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+  return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete,
+                     unsigned flags) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                 NULL, 0);
+}
+
+int uring_init(UringIO *ring, unsigned entries) {
+  struct io_uring_params p;
+  memset(ring, 0, sizeof(*ring));
+  memset(&p, 0, sizeof(p));
+
+  ring->fd = sys_setup(entries, &p);
+  if (ring->fd < 0)
+    return -1;
+  ring->entries = p.sq_entries;
+
+  ring->sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->cq_ring_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_ring_len > ring->sq_ring_len)
+      ring->sq_ring_len = ring->cq_ring_len;
+    ring->cq_ring_len = ring->sq_ring_len;
+  }
+
+  ring->sq_ring = mmap(0, ring->sq_ring_len, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED) {
+    uring_exit(ring);
+    return -1;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ring = ring->sq_ring;
+  } else {
+    ring->cq_ring =
+        mmap(0, ring->cq_ring_len, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ring == MAP_FAILED) {
+      uring_exit(ring);
+      return -1;
+    }
+  }
+
+  ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(0, ring->sqes_len, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    uring_exit(ring);
+    return -1;
+  }
+
+  char *sq = ring->sq_ring, *cq = ring->cq_ring;
+  ring->sq_khead = (unsigned *)(sq + p.sq_off.head);
+  ring->sq_ktail = (unsigned *)(sq + p.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+  ring->cq_khead = (unsigned *)(cq + p.cq_off.head);
+  ring->cq_ktail = (unsigned *)(cq + p.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  ring->cqes = cq + p.cq_off.cqes;
+  ring->sq_tail = *ring->sq_ktail;
+  return 0;
+}
+
+void uring_exit(UringIO *ring) {
+  if (ring->sqes && ring->sqes != MAP_FAILED)
+    munmap(ring->sqes, ring->sqes_len);
+  if (ring->cq_ring && ring->cq_ring != MAP_FAILED &&
+      ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_len);
+  if (ring->sq_ring && ring->sq_ring != MAP_FAILED)
+    munmap(ring->sq_ring, ring->sq_ring_len);
+  if (ring->fd > 0)
+    close(ring->fd);
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = -1;
+}
+
+int uring_register_buffers(UringIO *ring, const struct iovec *iovs,
+                           unsigned count) {
+  return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS,
+                 iovs, count) < 0
+             ? -1
+             : 0;
+}
+
+static struct io_uring_sqe *get_sqe(UringIO *ring) {
+  unsigned head = __atomic_load_n(ring->sq_khead, __ATOMIC_ACQUIRE);
+  if (ring->sq_tail - head >= ring->entries)
+    return NULL;
+  unsigned idx = ring->sq_tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = (struct io_uring_sqe *)ring->sqes + idx;
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[idx] = idx;
+  ring->sq_tail++;
+  ring->to_submit++;
+  return sqe;
+}
+
+int uring_prep_write_fixed(UringIO *ring, int fd, const void *buf,
+                           unsigned len, off_t offset, int buf_index,
+                           int link, unsigned long long user_data) {
+  struct io_uring_sqe *sqe = get_sqe(ring);
+  if (!sqe)
+    return -1;
+  sqe->opcode = IORING_OP_WRITE_FIXED;
+  sqe->fd = fd;
+  sqe->addr = (unsigned long)buf;
+  sqe->len = len;
+  sqe->off = offset;
+  sqe->buf_index = buf_index;
+  sqe->flags = link ? IOSQE_IO_LINK : 0;
+  sqe->user_data = user_data;
+  return 0;
+}
+
+int uring_prep_send(UringIO *ring, int fd, const void *buf, unsigned len,
+                    int link, unsigned long long user_data) {
+  struct io_uring_sqe *sqe = get_sqe(ring);
+  if (!sqe)
+    return -1;
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = fd;
+  sqe->addr = (unsigned long)buf;
+  sqe->len = len;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->flags = link ? IOSQE_IO_LINK : 0;
+  sqe->user_data = user_data;
+  return 0;
+}
+
+int uring_submit(UringIO *ring, unsigned wait_nr) {
+  __atomic_store_n(ring->sq_ktail, ring->sq_tail, __ATOMIC_RELEASE);
+  unsigned n = ring->to_submit;
+  ring->to_submit = 0;
+  int ret;
+  do {
+    ret = sys_enter(ring->fd, n, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+  } while (ret < 0 && errno == EINTR);
+  return ret;
+}
+
+int uring_wait(UringIO *ring, unsigned wait_nr) {
+  int ret;
+  do {
+    ret = sys_enter(ring->fd, 0, wait_nr, IORING_ENTER_GETEVENTS);
+  } while (ret < 0 && errno == EINTR);
+  return ret;
+}
+
+int uring_reap(UringIO *ring, unsigned long long *user_data, int *res) {
+  unsigned head = *ring->cq_khead;
+  if (head == __atomic_load_n(ring->cq_ktail, __ATOMIC_ACQUIRE))
+    return 0;
+  struct io_uring_cqe *cqe =
+      (struct io_uring_cqe *)ring->cqes + (head & *ring->cq_mask);
+  *user_data = cqe->user_data;
+  *res = cqe->res;
+  __atomic_store_n(ring->cq_khead, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+#else // !HAVE_IO_URING
+
+int uring_init(UringIO *ring, unsigned entries) {
+  (void)entries;
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = -1;
+  return -1;
+}
+void uring_exit(UringIO *ring) { (void)ring; }
+int uring_register_buffers(UringIO *ring, const struct iovec *iovs,
+                           unsigned count) {
+  (void)ring, (void)iovs, (void)count;
+  return -1;
+}
+int uring_prep_write_fixed(UringIO *ring, int fd, const void *buf,
+                           unsigned len, off_t offset, int buf_index,
+                           int link, unsigned long long user_data) {
+  (void)ring, (void)fd, (void)buf, (void)len, (void)offset, (void)buf_index,
+      (void)link, (void)user_data;
+  return -1;
+}
+int uring_prep_send(UringIO *ring, int fd, const void *buf, unsigned len,
+                    int link, unsigned long long user_data) {
+  (void)ring, (void)fd, (void)buf, (void)len, (void)link, (void)user_data;
+  return -1;
+}
+int uring_submit(UringIO *ring, unsigned wait_nr) {
+  (void)ring, (void)wait_nr;
+  return -1;
+}
+int uring_wait(UringIO *ring, unsigned wait_nr) {
+  (void)ring, (void)wait_nr;
+  return -1;
+}
+int uring_reap(UringIO *ring, unsigned long long *user_data, int *res) {
+  (void)ring, (void)user_data, (void)res;
+  return 0;
+}
+
+#endif // HAVE_IO_URING
+
+void send_pair(UringIO *ring, int sock, const char *first, size_t first_len,
+               const char *second, size_t second_len) {
+  if (ring->fd != -1 &&
+      uring_prep_send(ring, sock, first, first_len, 1, 0) == 0 &&
+      uring_prep_send(ring, sock, second, second_len, 0, 1) == 0 &&
+      uring_submit(ring, 2) >= 0) {
+    unsigned long long which;
+    int res;
+    for (int done = 0; done < 2;) {
+      while (uring_reap(ring, &which, &res))
+        done++;
+      if (done < 2)
+        uring_submit(ring, 1);
+    }
+    return;
+  }
+  send(sock, first, first_len, MSG_NOSIGNAL);
+  send(sock, second, second_len, MSG_NOSIGNAL);
+}
@@ -0,0 +1,250 @@
+#include "../include/vclock.h"
+#include <unistd.h>
+
+// A participant blocked on its virtual clock
+struct VClockWaiter {
+  sem_t *sem;         // Woken by a post to it, or NULL
+  long long deadline; // Virtual us, or -1 for none
+  int id;             // Thread id, for tie-breaking
+  int woken;
+  pthread_cond_t cond;
+  VClockWaiter *next;
+};
+
+// A vclock_thread_create() thread before it starts
+typedef struct {
+  void *(*fn)(void *);
+  void *arg;
+  VClock *clock;
+  int id;
+} ThreadStart;
+
+// The clock the calling thread takes part in, NULL for the wall clock
+static __thread VClock *thread_clock = NULL;
+static __thread int thread_id = 0;
+
+// All of the following run under clock->lock
+static void wake(VClock *clock, VClockWaiter *w) {
+  w->woken = 1;
+  clock->blocked--;
+  pthread_cond_signal(&w->cond);
+}
+
+// Once every participant is blocked, time jumps to the earliest deadline
+// and that one waiter runs. Waking a single thread per step keeps the
+// order of events the same from run to run.
+static void advance(VClock *clock) {
+  if (clock->blocked == 0 || clock->blocked < clock->participants)
+    return;
+  VClockWaiter *first = NULL;
+  for (VClockWaiter *w = clock->waiters; w; w = w->next) {
+    if (w->woken || w->deadline < 0)
+      continue;
+    if (!first || w->deadline < first->deadline ||
+        (w->deadline == first->deadline && w->id < first->id))
+      first = w;
+  }
+  if (!first)
+    return; // Nothing can ever wake them: a wait with no post coming
+  if (first->deadline > clock->now_us)
+    clock->now_us = first->deadline;
+  wake(clock, first);
+}
+
+static void unlink_waiter(VClock *clock, VClockWaiter *w) {
+  for (VClockWaiter **p = &clock->waiters; *p; p = &(*p)->next) {
+    if (*p == w) {
+      *p = w->next;
+      break;
+    }
+  }
+}
+
+// A participant cancelled while blocked (pthread_cond_wait() is a
+// cancellation point) stops being a waiter; thread_left() does the rest
+static void wait_cancelled(void *arg) {
+  VClockWaiter *w = arg;
+  unlink_waiter(thread_clock, w);
+  if (!w->woken)
+    thread_clock->blocked--;
+  pthread_mutex_unlock(&thread_clock->lock);
+  pthread_cond_destroy(&w->cond);
+}
+
+// Waits on virtual time until sem can be taken (if given) or us have
+// passed (us < 0: no limit). Returns 0 with sem taken, -1 on timeout.
+static int virtual_wait(VClock *clock, sem_t *sem, long us) {
+  VClockWaiter w;
+  int ret;
+  // A lone participant never reaches pthread_cond_wait(), so it is
+  // cancellable here too
+  pthread_testcancel();
+  memset(&w, 0, sizeof(w));
+  w.sem = sem;
+  w.id = thread_id;
+  pthread_cond_init(&w.cond, NULL);
+
+  pthread_mutex_lock(&clock->lock);
+  w.deadline = us < 0 ? -1 : clock->now_us + us;
+  pthread_cleanup_push(wait_cancelled, &w);
+  while (1) {
+    if (sem && sem_trywait(sem) == 0) {
+      ret = 0;
+      break;
+    }
+    if (w.deadline >= 0 && clock->now_us >= w.deadline) {
+      ret = -1;
+      break;
+    }
+    w.woken = 0;
+    w.next = clock->waiters;
+    clock->waiters = &w;
+    clock->blocked++;
+    advance(clock);
+    while (!w.woken)
+      pthread_cond_wait(&w.cond, &clock->lock);
+    unlink_waiter(clock, &w);
+  }
+  pthread_cleanup_pop(0);
+  pthread_mutex_unlock(&clock->lock);
+  pthread_cond_destroy(&w.cond);
+  return ret;
+}
+
+void vclock_init(VClock *clock) {
+  memset(clock, 0, sizeof(*clock));
+  pthread_mutex_init(&clock->lock, NULL);
+  clock->participants = 1;
+  clock->next_id = 1;
+  thread_clock = clock;
+  thread_id = 0;
+}
+
+void vclock_destroy(VClock *clock) { pthread_mutex_destroy(&clock->lock); }
+
+VClock *vclock_current(void) { return thread_clock; }
+
+void vclock_thread_exit(void) {
+  VClock *clock = thread_clock;
+  if (!clock)
+    return;
+  pthread_mutex_lock(&clock->lock);
+  clock->participants--;
+  advance(clock);
+  pthread_mutex_unlock(&clock->lock);
+  thread_clock = NULL;
+}
+
+static void thread_left(void *arg) {
+  (void)arg;
+  vclock_thread_exit();
+}
+
+static void *thread_main(void *arg) {
+  ThreadStart start = *(ThreadStart *)arg;
+  void *ret;
+  free(arg);
+  thread_clock = start.clock;
+  thread_id = start.id;
+  pthread_cleanup_push(thread_left, NULL);
+  ret = start.fn(start.arg);
+  pthread_cleanup_pop(1);
+  return ret;
+}
+
+int vclock_thread_create(pthread_t *tid, void *(*fn)(void *), void *arg) {
+  VClock *clock = thread_clock;
+  if (!clock)
+    return pthread_create(tid, NULL, fn, arg);
+
+  ThreadStart *start = malloc(sizeof(ThreadStart));
+  if (!start)
+    return ENOMEM;
+  start->fn = fn;
+  start->arg = arg;
+  start->clock = clock;
+  // Counted from here, so time cannot move before the thread gets going
+  pthread_mutex_lock(&clock->lock);
+  start->id = clock->next_id++;
+  clock->participants++;
+  pthread_mutex_unlock(&clock->lock);
+
+  int ret = pthread_create(tid, NULL, thread_main, start);
+  if (ret != 0) {
+    free(start);
+    pthread_mutex_lock(&clock->lock);
+    clock->participants--;
+    advance(clock);
+    pthread_mutex_unlock(&clock->lock);
+  }
+  return ret;
+}
+
+void vclock_sleep_us(long us) {
+  if (thread_clock) {
+    virtual_wait(thread_clock, NULL, us);
+    return;
+  }
+  usleep(us);
+}
+
+void vclock_sleep(int sec) { vclock_sleep_us(sec * 1000000L); }
+
+time_t vclock_now(void) { return vclock_now_us() / 1000000; }
+
+long long vclock_now_us(void) {
+  VClock *clock = thread_clock;
+  if (clock) {
+    pthread_mutex_lock(&clock->lock);
+    long long now = clock->now_us;
+    pthread_mutex_unlock(&clock->lock);
+    return now;
+  }
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+int vclock_sem_wait(sem_t *sem) {
+  if (thread_clock)
+    return virtual_wait(thread_clock, sem, -1);
+  return sem_wait(sem);
+}
+
+int vclock_sem_timedwait(sem_t *sem, long us) {
+  if (thread_clock) {
+    if (virtual_wait(thread_clock, sem, us) == 0)
+      return 0;
+    errno = ETIMEDOUT;
+    return -1;
+  }
+#ifdef __linux__
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_nsec += us * 1000;
+  deadline.tv_sec += deadline.tv_nsec / 1000000000;
+  deadline.tv_nsec %= 1000000000;
+  return sem_timedwait(sem, &deadline);
+#else
+  usleep(us); // No sem_timedwait on named semaphores
+  return sem_trywait(sem);
+#endif
+}
+
+// Wakes the lowest-id participant waiting on sem
+int vclock_sem_post(sem_t *sem) {
+  VClock *clock = thread_clock;
+  if (!clock)
+    return sem_post(sem);
+  pthread_mutex_lock(&clock->lock);
+  int ret = sem_post(sem);
+  VClockWaiter *first = NULL;
+  for (VClockWaiter *w = clock->waiters; w; w = w->next) {
+    if (!w->woken && w->sem == sem && (!first || w->id < first->id))
+      first = w;
+  }
+  if (first)
+    wake(clock, first);
+  pthread_mutex_unlock(&clock->lock);
+  return ret;
+}